@@ -1,4 +1,5 @@
 #include "AMS_TSL2591.h"
+#include "telemetry.h"  // multidrop_active: no unsolicited prints on a shared bus
 
 AMS_TSL2591::AMS_TSL2591() : tsl(2591) {
     current_gain = TSL2591_GAIN_MED;
@@ -7,6 +8,73 @@ AMS_TSL2591::AMS_TSL2591() : tsl(2591) {
     previous_measurement = 0;
     improvement_detected = false;
     last_adjustment_type = ADJUST_NONE;
+    predictive_mode = true;
+    probe_pending = false;
+    full_stats.reset();
+    ir_stats.reset();
+}
+
+void AMS_TSL2591::WindowStats::reset() {
+    index = 0;
+    count = 0;
+    sum = 0;
+    sum_sq = 0;
+    min_value = 0;
+    max_value = 0;
+}
+
+void AMS_TSL2591::WindowStats::push(uint16_t value) {
+    bool need_rescan = false;
+
+    if (count < MOVING_AVG_SIZE) {
+        count++;
+    } else {
+        // Evict the oldest sample from the running sums
+        uint16_t old = buffer[index];
+        sum -= old;
+        sum_sq -= (uint64_t)old * old;
+        // Extremes only need a rescan when the evicted sample held them
+        need_rescan = (old == min_value || old == max_value);
+    }
+
+    buffer[index] = value;
+    index = (index + 1) % MOVING_AVG_SIZE;
+    sum += value;
+    sum_sq += (uint64_t)value * value;
+
+    if (count == 1) {
+        min_value = value;
+        max_value = value;
+    } else if (need_rescan) {
+        rescanExtremes();
+    } else {
+        if (value < min_value) min_value = value;
+        if (value > max_value) max_value = value;
+    }
+}
+
+void AMS_TSL2591::WindowStats::rescanExtremes() {
+    min_value = 0xFFFF;
+    max_value = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (buffer[i] < min_value) min_value = buffer[i];
+        if (buffer[i] > max_value) max_value = buffer[i];
+    }
+}
+
+uint16_t AMS_TSL2591::WindowStats::mean() const {
+    if (count == 0) {
+        return 0;
+    }
+    return (uint16_t)(sum / count);
+}
+
+float AMS_TSL2591::WindowStats::variance() const {
+    if (count < 2) {
+        return 0.0f;
+    }
+    float m = (float)sum / count;
+    return (float)sum_sq / count - m * m;
 }
 
 bool AMS_TSL2591::begin(TwoWire *wire) {
@@ -76,6 +144,98 @@ const char* AMS_TSL2591::getIntegrationTimeString(tsl2591IntegrationTime_t integ
     }
 }
 
+void AMS_TSL2591::applySettings(tsl2591Gain_t gain, tsl2591IntegrationTime_t integration_time) {
+    current_gain = gain;
+    current_integration_time = integration_time;
+
+    tsl.setGain(current_gain);
+    tsl.setTiming(current_integration_time);
+
+    // Auto-gain fires on its own schedule (every dusk/dawn transition) -
+    // on a shared multi-drop bus the notice has to stay off the wire
+    if (!multidrop_active) {
+        Serial.print("# Gain adjusted to: ");
+        Serial.println(getGainString(current_gain));
+
+        Serial.print("# Integration time adjusted to: ");
+        Serial.println((int)getIntegrationTimeMs(current_integration_time));
+    }
+}
+
+bool AMS_TSL2591::predictiveAdjust(uint16_t full_value) {
+    // Middle of the 1500..30000 target window for raw full counts
+    const float TARGET_COUNT = 20000.0f;
+
+    // Saturated counts carry no rate information - take one short
+    // low-gain probe and compute the jump from its reading
+    if (full_value > GAIN_SATURATED_THRESHOLD && !probe_pending) {
+        if (current_gain == TSL2591_GAIN_LOW &&
+            current_integration_time == TSL2591_INTEGRATIONTIME_100MS) {
+            return false; // already at minimum sensitivity
+        }
+        if (!multidrop_active) {
+            Serial.println("# Auto-gain: saturated, probing at 1x/100ms");
+        }
+        applySettings(TSL2591_GAIN_LOW, TSL2591_INTEGRATIONTIME_100MS);
+        probe_pending = true;
+        return true;
+    }
+
+    // Inside the target window: nothing to do
+    if (!probe_pending &&
+        full_value >= INTEGRATION_TIME_INCREASE_THRESHOLD &&
+        full_value <= INTEGRATION_TIME_DECREASE_THRESHOLD) {
+        return false;
+    }
+    probe_pending = false;
+
+    if (full_value == 0) {
+        full_value = 1;
+    }
+
+    // Counts per (gain * ms); target product puts the count mid-window
+    float rate = (float)full_value /
+                 (getGainValue(current_gain) * getIntegrationTimeMs(current_integration_time));
+    float target_product = TARGET_COUNT / rate;
+
+    // Pick the gain/integration combination whose product is closest to
+    // the target without overshooting into saturation
+    static const tsl2591Gain_t gains[4] = {
+        TSL2591_GAIN_LOW, TSL2591_GAIN_MED, TSL2591_GAIN_HIGH, TSL2591_GAIN_MAX
+    };
+    static const tsl2591IntegrationTime_t times[6] = {
+        TSL2591_INTEGRATIONTIME_100MS, TSL2591_INTEGRATIONTIME_200MS,
+        TSL2591_INTEGRATIONTIME_300MS, TSL2591_INTEGRATIONTIME_400MS,
+        TSL2591_INTEGRATIONTIME_500MS, TSL2591_INTEGRATIONTIME_600MS
+    };
+
+    tsl2591Gain_t best_gain = TSL2591_GAIN_LOW;
+    tsl2591IntegrationTime_t best_time = TSL2591_INTEGRATIONTIME_100MS;
+    float best_product = 1.0f * 100.0f;
+
+    for (uint8_t g = 0; g < 4; g++) {
+        for (uint8_t t = 0; t < 6; t++) {
+            float product = getGainValue(gains[g]) * getIntegrationTimeMs(times[t]);
+            // Never pick a combination predicted to exceed the window top
+            if (rate * product > (float)INTEGRATION_TIME_DECREASE_THRESHOLD) {
+                continue;
+            }
+            if (product > best_product && product <= target_product) {
+                best_product = product;
+                best_gain = gains[g];
+                best_time = times[t];
+            }
+        }
+    }
+
+    if (best_gain == current_gain && best_time == current_integration_time) {
+        return false;
+    }
+
+    applySettings(best_gain, best_time);
+    return true;
+}
+
 bool AMS_TSL2591::adjustGainAndIntegrationTime(uint16_t full_value) {
     tsl2591Gain_t new_gain = current_gain;
     tsl2591IntegrationTime_t new_integration_time = current_integration_time;
@@ -206,18 +366,7 @@ bool AMS_TSL2591::adjustGainAndIntegrationTime(uint16_t full_value) {
     }
 
     // Apply new gain and integration time
-    current_gain = new_gain;
-    current_integration_time = new_integration_time;
-    
-    tsl.setGain(current_gain);
-    tsl.setTiming(current_integration_time);
-
-    Serial.print("# Gain adjusted to: ");
-    Serial.println(getGainString(current_gain));
-
-    Serial.print("# Integration time adjusted to: ");
-    Serial.println((int)current_integration_time * 100);
-
+    applySettings(new_gain, new_integration_time);
     return true;
 }
 
@@ -249,21 +398,11 @@ bool AMS_TSL2591::readLightData(uint32_t &ulux, uint16_t &full_avg, uint16_t &ir
     uint16_t ir_raw = lum >> 16;
     uint16_t full_raw = lum & 0xFFFF;
     
-    full_buffer[buffer_index] = full_raw;
-    ir_buffer[buffer_index] = ir_raw;
-    buffer_index = (buffer_index + 1) % MOVING_AVG_SIZE;
-    if (buffer_count < MOVING_AVG_SIZE) {
-        buffer_count++;
-    }
-    
-    uint32_t full_sum = 0;
-    uint32_t ir_sum = 0;
-    for (uint8_t i = 0; i < buffer_count; i++) {
-        full_sum += full_buffer[i];
-        ir_sum += ir_buffer[i];
-    }
-    full_avg = full_sum / buffer_count;
-    ir_avg = ir_sum / buffer_count;
+    full_stats.push(full_raw);
+    ir_stats.push(ir_raw);
+
+    full_avg = full_stats.mean();
+    ir_avg = ir_stats.mean();
     
     float lux = calculateLuxFromRaw(full_avg, ir_avg);
     
@@ -274,7 +413,17 @@ bool AMS_TSL2591::readLightData(uint32_t &ulux, uint16_t &full_avg, uint16_t &ir
     }
     
     unsigned long current_time = millis();
-    if (current_time - last_gain_adjustment >= GAIN_ADJUSTMENT_INTERVAL) {
+    if (predictive_mode) {
+        // One adjustment converges, so only one integration cycle of
+        // holdoff is needed for the new settings to take effect
+        unsigned long holdoff = (unsigned long)(2.0f * getIntegrationTimeMsCurrent());
+        if (current_time - last_gain_adjustment >= holdoff) {
+            if (predictiveAdjust(full_raw)) {
+                last_gain_adjustment = current_time;
+                return false;
+            }
+        }
+    } else if (current_time - last_gain_adjustment >= GAIN_ADJUSTMENT_INTERVAL) {
         if (adjustGainAndIntegrationTime(full_raw)) {
             last_gain_adjustment = current_time;
             return false;
@@ -15,12 +15,35 @@ private:
     uint16_t previous_measurement;
     bool improvement_detected;
     
-    // Moving average buffers
-    static const uint8_t MOVING_AVG_SIZE = 16;
-    uint16_t full_buffer[MOVING_AVG_SIZE];
-    uint16_t ir_buffer[MOVING_AVG_SIZE];
-    uint8_t buffer_index;
-    uint8_t buffer_count;
+    // Windowed statistics over the last MOVING_AVG_SIZE samples.
+    // Mean and variance are maintained from running sums in O(1) per
+    // sample instead of re-summing the whole buffer on every read, so the
+    // window can grow for dark-sky noise reduction at no per-call cost.
+    static const uint8_t MOVING_AVG_SIZE = 64;
+
+    struct WindowStats {
+        uint16_t buffer[MOVING_AVG_SIZE];
+        uint8_t index;
+        uint8_t count;
+        uint32_t sum;
+        uint64_t sum_sq;
+        uint16_t min_value;
+        uint16_t max_value;
+
+        void reset();
+        void push(uint16_t value);
+        uint16_t mean() const;
+        float variance() const;
+        uint16_t minimum() const { return count ? min_value : 0; }
+        uint16_t maximum() const { return count ? max_value : 0; }
+
+    private:
+        // Only needed when the evicted sample was the current extreme
+        void rescanExtremes();
+    };
+
+    WindowStats full_stats;
+    WindowStats ir_stats;
     
     // Thresholds
     static const unsigned long GAIN_ADJUSTMENT_INTERVAL = 5000;
@@ -39,13 +62,21 @@ private:
         ADJUST_BOTH = 3
     };
     LastAdjustmentType last_adjustment_type;
-    
+
+    // Predictive auto-gain: compute the target gain*integration product
+    // from the measured count rate and jump straight to it (one
+    // adjustment) instead of laddering one notch per interval
+    bool predictive_mode;
+    bool probe_pending;       // waiting for the low-gain probe reading
+
     // Helper functions
     const char* getGainString(tsl2591Gain_t gain);
     float getGainValue(tsl2591Gain_t gain) const;
     float getIntegrationTimeMs(tsl2591IntegrationTime_t integrationTime) const;
     const char* getIntegrationTimeString(tsl2591IntegrationTime_t integrationTime);
+    void applySettings(tsl2591Gain_t gain, tsl2591IntegrationTime_t integration_time);
     bool adjustGainAndIntegrationTime(uint16_t full_value);
+    bool predictiveAdjust(uint16_t full_value);
     float calculateLuxFromRaw(uint16_t ch0_full, uint16_t ch1_ir);
     
 public:
@@ -62,11 +93,25 @@ public:
     bool readLightData(uint32_t &ulux, uint16_t &full_avg, uint16_t &ir_avg, 
                        const char* &gain_str, const char* &integration_time_str);
     
+    // Windowed statistics of the raw full-spectrum/IR channels
+    uint16_t getFullMean() const { return full_stats.mean(); }
+    uint16_t getFullMin() const { return full_stats.minimum(); }
+    uint16_t getFullMax() const { return full_stats.maximum(); }
+    float getFullVariance() const { return full_stats.variance(); }
+    uint16_t getIrMean() const { return ir_stats.mean(); }
+    uint16_t getIrMin() const { return ir_stats.minimum(); }
+    uint16_t getIrMax() const { return ir_stats.maximum(); }
+    float getIrVariance() const { return ir_stats.variance(); }
+
     // Settings
     float getGainValueCurrent() const { return getGainValue(current_gain); }
     float getIntegrationTimeMsCurrent() const { return getIntegrationTimeMs(current_integration_time); }
     tsl2591Gain_t getCurrentGain() const { return current_gain; }
     tsl2591IntegrationTime_t getCurrentIntegrationTime() const { return current_integration_time; }
+
+    // Predictive (one-shot) vs. stepwise auto-gain; predictive is default
+    void setPredictiveAutoGain(bool enabled) { predictive_mode = enabled; }
+    bool getPredictiveAutoGain() const { return predictive_mode; }
 };
 
 #endif
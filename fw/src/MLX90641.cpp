@@ -1,13 +1,206 @@
 #include "MLX90641.h"
 
+#include <pico/time.h>
+#include <LittleFS.h>
+
 #include "mlx90641-library/headers/MLX90641_API.h"
 #include "mlx90641-library/headers/MLX90641_I2C_Driver.h"
+#include "telemetry.h"  // telemetryCrc16 pro klíčování cache kalibrace
+
+// Soubor s cache extrahované kalibrace. ID slova senzoru (EEPROM
+// 0x2407-0x2409) odliší vyměněný modul bez plného dumpu, CRC celé EEPROM
+// slouží k ověření na pozadí.
+#define MLX_CAL_CACHE_PATH "/mlx_cal.bin"
+#define MLX_CAL_CACHE_MAGIC 0x4D43414Cu  // "MCAL"
+#define MLX_CAL_CACHE_VERSION 1
+
+struct MlxCalCacheFile {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t id[3];        // ID slova senzoru
+    uint16_t eeCrc;        // CRC16-CCITT přes všech 832 slov EEPROM
+    uint16_t structCrc;    // CRC16 přes paramsMLX90641 níže
+    paramsMLX90641 params;
+};
+
+static bool mlxFsReady()
+{
+    static bool tried = false;
+    static bool ready = false;
+    if (!tried)
+    {
+        tried = true;
+        ready = LittleFS.begin();
+    }
+    return ready;
+}
 
 MLX90641::MLX90641()
 {
     _wire = nullptr;
     initialized = false;
     hasValidFrame = false;
+    frontIndex = 0;
+    producedFrames = 0;
+    consumedFrames = 0;
+    workerRunning = false;
+    workerStartRequested = false;
+    fastTablesReady = false;
+    acqState = ACQ_WAIT_DATA;
+    acqWordsRead = 0;
+    acqSubPage = 0;
+    lastFrameUs = 0;
+    calCrc = 0;
+    calVerifyPending = false;
+    calCacheDirty = false;
+    refreshCode = 0b011;  // 4 Hz, viz begin()
+    framesDropped = 0;
+    subpageMisses = 0;
+    acqErrors = 0;
+    lastSubpage = -1;
+}
+
+void MLX90641::noteSubpage(uint16_t subPage)
+{
+    // Subpage se střídají 0/1; stejné číslo dvakrát po sobě znamená
+    // jeden prošvihnutý snímek
+    if (lastSubpage >= 0 && (int8_t)subPage == lastSubpage)
+    {
+        subpageMisses = subpageMisses + 1;
+    }
+    lastSubpage = (int8_t)subPage;
+}
+
+bool MLX90641::setRefreshRate(uint8_t code)
+{
+    if (code > 7)
+    {
+        return false;
+    }
+    refreshCode = code;
+
+    if (!initialized)
+    {
+        // Zapíše se při begin()
+        return true;
+    }
+    if (MLX90641_SetRefreshRate(MLX90641_I2C_ADDR, code) != 0)
+    {
+        return false;
+    }
+    return true;
+}
+
+bool MLX90641::loadCalibrationCache()
+{
+    if (!mlxFsReady())
+    {
+        return false;
+    }
+
+    File f = LittleFS.open(MLX_CAL_CACHE_PATH, "r");
+    if (!f)
+    {
+        return false;
+    }
+
+    MlxCalCacheFile cache;
+    size_t n = f.read((uint8_t *)&cache, sizeof(cache));
+    f.close();
+
+    if (n != sizeof(cache) || cache.magic != MLX_CAL_CACHE_MAGIC ||
+        cache.version != MLX_CAL_CACHE_VERSION)
+    {
+        return false;
+    }
+    if (telemetryCrc16((const uint8_t *)&cache.params, sizeof(cache.params)) != cache.structCrc)
+    {
+        return false;
+    }
+
+    // Krátké čtení ID slov místo dumpu celé EEPROM - odhalí vyměněný senzor
+    uint16_t id[3];
+    if (MLX90641_I2CRead(MLX90641_I2C_ADDR, 0x2407, 3, id) != 0)
+    {
+        return false;
+    }
+    if (id[0] != cache.id[0] || id[1] != cache.id[1] || id[2] != cache.id[2])
+    {
+        return false;
+    }
+
+    calibration = cache.params;
+    calCrc = cache.eeCrc;
+    calVerifyPending = true;
+    return true;
+}
+
+void MLX90641::saveCalibrationCache()
+{
+    if (!mlxFsReady())
+    {
+        return;
+    }
+
+    MlxCalCacheFile cache;
+    cache.magic = MLX_CAL_CACHE_MAGIC;
+    cache.version = MLX_CAL_CACHE_VERSION;
+    cache.id[0] = eeData[7];
+    cache.id[1] = eeData[8];
+    cache.id[2] = eeData[9];
+    cache.eeCrc = calCrc;
+    cache.params = calibration;
+    cache.structCrc = telemetryCrc16((const uint8_t *)&cache.params, sizeof(cache.params));
+
+    File f = LittleFS.open(MLX_CAL_CACHE_PATH, "w");
+    if (!f)
+    {
+        return;
+    }
+    f.write((const uint8_t *)&cache, sizeof(cache));
+    f.close();
+}
+
+void MLX90641::verifyCalibration()
+{
+    calVerifyPending = false;
+
+    // Plný dump EEPROM a porovnání CRC s klíčem cache. Běží na pozadí
+    // (worker na core1 před první akvizicí, případně první poll()),
+    // takže start měření na něj nečeká.
+    if (MLX90641_DumpEE(MLX90641_I2C_ADDR, eeData) != 0)
+    {
+        return;
+    }
+
+    uint16_t crc = telemetryCrc16((const uint8_t *)eeData, sizeof(eeData));
+    if (crc == calCrc)
+    {
+        return;
+    }
+
+    // Cache neodpovídá skutečné EEPROM - přepočítat a označit k uložení
+    // (samotný zápis do flash dělá core0 v serviceCalibrationCache)
+    if (MLX90641_ExtractParameters(eeData, &calibration) == 0)
+    {
+        calCrc = crc;
+        buildFastTables();
+        calCacheDirty = true;
+    }
+}
+
+void MLX90641::serviceCalibrationCache()
+{
+    if (calCacheDirty)
+    {
+        calCacheDirty = false;
+        saveCalibrationCache();
+        // Přichází kdykoli po bootu - na sdílené sběrnici nic nehlásit
+        if (!multidrop_active)
+        {
+            Serial.println("# MLX90641 calibration cache refreshed");
+        }
+    }
 }
 
 bool MLX90641::begin(TwoWire *wire)
@@ -16,44 +209,81 @@ bool MLX90641::begin(TwoWire *wire)
     initialized = false;
     hasValidFrame = false;
 
+    // begin() běží až z bringup tasku, tedy po načtení konfigurace -
+    // multidrop_active už platí a na sdílené sběrnici se nic nehlásí
     if (_wire == nullptr)
     {
-        Serial.println("# MLX90641: invalid Wire instance");
+        if (!multidrop_active)
+        {
+            Serial.println("# MLX90641: invalid Wire instance");
+        }
         return false;
     }
 
-    // Inicializace I2C driveru knihovny (frekvence nastavíme na 400 kHz)
+    // Inicializace I2C driveru knihovny. Driver dostane instanci Wire,
+    // na které senzor skutečně běží - při vlastním řadiči (I2C0) se pak
+    // nepoužívá sdílený zámek sběrnice. Výchozí takt je 400 kHz; senzor
+    // umí FM+ (1 MHz), na deskách s odpovídajícími pull-upy lze zapnout
+    // přes -DMLX_I2C_KHZ=1000.
+    MLX90641_I2CSetWire(_wire);
     MLX90641_I2CInit();
-    MLX90641_I2CFreqSet(400);
+    MLX90641_I2CFreqSet(MLX_I2C_KHZ);
 
     // Ověření I2C spojení jednoduchým přenosem
     _wire->beginTransmission(MLX90641_I2C_ADDR);
     if (_wire->endTransmission() != 0)
     {
-        Serial.println("# MLX90641 thermal sensor initialization failed (I2C)");
+        if (!multidrop_active)
+        {
+            Serial.println("# MLX90641 thermal sensor initialization failed (I2C)");
+        }
         return false;
     }
 
-    // Načtení EEPROM a kalibračních parametrů
-    int status = MLX90641_DumpEE(MLX90641_I2C_ADDR, eeData);
-    if (status != 0)
+    // Kalibrace: nejdřív zkusit cache ve flash (warm boot bez dumpu
+    // 832 slov), teprve při neúspěchu plná cesta přes EEPROM
+    if (loadCalibrationCache())
     {
-        Serial.print("# MLX90641_DumpEE failed, err=");
-        Serial.println(status);
-        return false;
+        if (!multidrop_active)
+        {
+            Serial.println("# MLX90641 calibration loaded from cache");
+        }
     }
-
-    status = MLX90641_ExtractParameters(eeData, &calibration);
-    if (status != 0)
+    else
     {
-        Serial.print("# MLX90641_ExtractParameters failed, err=");
-        Serial.println(status);
-        return false;
+        int status = MLX90641_DumpEE(MLX90641_I2C_ADDR, eeData);
+        if (status != 0)
+        {
+            if (!multidrop_active)
+            {
+                Serial.print("# MLX90641_DumpEE failed, err=");
+                Serial.println(status);
+            }
+            return false;
+        }
+
+        status = MLX90641_ExtractParameters(eeData, &calibration);
+        if (status != 0)
+        {
+            if (!multidrop_active)
+            {
+                Serial.print("# MLX90641_ExtractParameters failed, err=");
+                Serial.println(status);
+            }
+            return false;
+        }
+
+        calCrc = telemetryCrc16((const uint8_t *)eeData, sizeof(eeData));
+        saveCalibrationCache();
     }
 
-    // Nastavíme refresh rate na 4 Hz (011b), aby byl rozumný kompromis mezi šumem a rychlostí
-    status = MLX90641_SetRefreshRate(MLX90641_I2C_ADDR, 0b011);
-    if (status != 0)
+    // Kalibrace se už nemění - předpočítat tabulky pro rychlý výpočet To[]
+    buildFastTables();
+
+    // Refresh rate dle konfigurace (výchozí 4 Hz jako kompromis mezi
+    // šumem a rychlostí; 16 Hz pro meteor-scatter korelaci)
+    int status = MLX90641_SetRefreshRate(MLX90641_I2C_ADDR, refreshCode);
+    if (status != 0 && !multidrop_active)
     {
         Serial.print("# MLX90641_SetRefreshRate failed, err=");
         Serial.println(status);
@@ -61,7 +291,10 @@ bool MLX90641::begin(TwoWire *wire)
     }
 
     initialized = true;
-    Serial.println("# MLX90641 thermal sensor initialized successfully");
+    if (!multidrop_active)
+    {
+        Serial.println("# MLX90641 thermal sensor initialized successfully");
+    }
     return true;
 }
 
@@ -70,6 +303,402 @@ bool MLX90641::isAvailable() const
     return initialized;
 }
 
+#ifndef SCALEALPHA
+#define SCALEALPHA 0.000001f
+#endif
+
+void MLX90641::buildFastTables()
+{
+    // Škálovací konstanty; v knihovně se počítají přes pow() každý frame
+    float ktaScale = (float)(1 << calibration.ktaScale);
+    float kvScale = (float)(1 << calibration.kvScale);
+    float alphaScale = (float)(1 << calibration.alphaScale);
+
+    for (int i = 0; i < MLX90641_PIXEL_COUNT; ++i)
+    {
+        fastKta[i] = (float)calibration.kta[i] / ktaScale;
+        fastKv[i] = (float)calibration.kv[i] / kvScale;
+        fastOffset[0][i] = (float)calibration.offset[0][i];
+        fastOffset[1][i] = (float)calibration.offset[1][i];
+        fastInvAlpha[i] = SCALEALPHA * alphaScale / (float)calibration.alpha[i];
+    }
+
+    // Korekce teplotních rozsahů (stejné vzorce jako v MLX90641_CalculateTo)
+    fastAlphaCorr[0] = 1.0f / (1.0f + calibration.ksTo[0] * 40.0f);
+    fastAlphaCorr[1] = 1.0f;
+    for (int r = 2; r < 8; ++r)
+    {
+        fastAlphaCorr[r] = fastAlphaCorr[r - 1] *
+            (1.0f + calibration.ksTo[r - 1] *
+             (float)(calibration.ct[r] - calibration.ct[r - 1]));
+    }
+
+    fastTablesReady = true;
+}
+
+void MLX90641::calculateToFast(float vdd, float ta, float emissivity, float tr,
+                               float *result)
+{
+    uint16_t subPage = frameData[241] & 0x0001;
+
+    // Sdílené členy na celý frame
+    float taK = ta + 273.15f;
+    float trK = tr + 273.15f;
+    float ta4 = taK * taK * taK * taK;
+    float tr4 = trK * trK * trK * trK;
+    float taTr = tr4 - (tr4 - ta4) / emissivity;
+
+    // GAIN slovo (RAM 0x058A -> index 192 + 0x0A = 202)
+    float gain = (float)calibration.gainEE / (float)(int16_t)frameData[202];
+
+    float ktaTa = ta - 25.0f;
+    float kvVdd = vdd - 3.3f;
+    float ksTaCorr = 1.0f + calibration.KsTa * ktaTa;
+    float invEmissivity = 1.0f / emissivity;
+    float ksTo1 = calibration.ksTo[1];
+
+    // Gradientová kompenzace (datasheet §11.2.2.7): CP pixel daného
+    // subpage (RAM 0x0588/0x05A8) se zkompenzuje jednou na frame a jeho
+    // tgc-násobek se odečítá od každého pixelu. Na kusech bez TGC je
+    // tgc = 0 a člen zmizí.
+    float irDataCP = (float)(int16_t)frameData[subPage ? 232 : 200] * gain;
+    irDataCP -= (float)calibration.cpOffset
+                * (1.0f + calibration.cpKta * ktaTa)
+                * (1.0f + calibration.cpKv * kvVdd);
+    float tgcIrCP = calibration.tgc * irDataCP;
+
+    const float *offsets = fastOffset[subPage];
+
+    for (int i = 0; i < MLX90641_PIXEL_COUNT; ++i)
+    {
+        // Kompenzace gain/offset/kta/kv - čistý multiply-add nad tabulkami
+        float irData = (float)(int16_t)frameData[i] * gain;
+        irData -= offsets[i] * (1.0f + fastKta[i] * ktaTa)
+                             * (1.0f + fastKv[i] * kvVdd);
+        irData *= invEmissivity;
+        irData -= tgcIrCP;
+
+        float alphaComp = fastInvAlpha[i] * ksTaCorr;
+
+        // Stejná posloupnost jako MLX90641_CalculateTo, čtvrtá odmocnina
+        // přes dvě sqrtf místo pow(x, 0.25)
+        float sx = alphaComp * alphaComp * alphaComp *
+                   (irData + alphaComp * taTr);
+        sx = sqrtf(sqrtf(sx)) * ksTo1;
+
+        float to = sqrtf(sqrtf(irData /
+                   (alphaComp * (1.0f - ksTo1 * 273.15f) + sx) + taTr)) - 273.15f;
+
+        // Výběr teplotního rozsahu a finální korekce
+        int range = 1;
+        for (int r = 7; r >= 2; --r)
+        {
+            if (to >= (float)calibration.ct[r])
+            {
+                range = r;
+                break;
+            }
+        }
+        if (to < (float)calibration.ct[1])
+        {
+            range = 0;
+        }
+
+        to = sqrtf(sqrtf(irData /
+             (alphaComp * fastAlphaCorr[range] *
+              (1.0f + calibration.ksTo[range] * (to - (float)calibration.ct[range]))) + taTr)) - 273.15f;
+
+        result[i] = to;
+    }
+}
+
+bool MLX90641::dataReady()
+{
+    // Status registr 0x8000, bit 3 = nová data k dispozici
+    uint16_t statusReg = 0;
+    if (MLX90641_I2CRead(MLX90641_I2C_ADDR, 0x8000, 1, &statusReg) != 0)
+    {
+        return false;
+    }
+    return (statusReg & 0x0008) != 0;
+}
+
+bool MLX90641::acquireAndCompute(MLX90641Frame &out)
+{
+    // Data ready už je ověřené, takže GetFrameData nečeká a vrátí se rychle
+    int status = MLX90641_GetFrameData(MLX90641_I2C_ADDR, frameData);
+    if (status < 0)
+    {
+        acqErrors = acqErrors + 1;
+        return false;
+    }
+    noteSubpage(frameData[241]);
+
+    out.vdd = MLX90641_GetVdd(frameData, &calibration);
+    out.ta = MLX90641_GetTa(frameData, &calibration);
+
+    // Emisivita z EEPROM, odražená teplota přibližně Ta-5°C dle datasheetu
+    float emissivity = MLX90641_GetEmissivity(&calibration);
+    float tr = out.ta - 5.0f;
+
+    // Float-heavy výpočet To[] běží na core1, core0 není blokované
+    if (fastTablesReady)
+    {
+        calculateToFast(out.vdd, out.ta, emissivity, tr, out.map);
+    }
+    else
+    {
+        MLX90641_CalculateTo(frameData, &calibration, emissivity, tr, out.map);
+    }
+    return true;
+}
+
+void MLX90641::workerRun()
+{
+    if (!workerStartRequested)
+    {
+        sleep_ms(5);
+        return;
+    }
+    workerLoop();  // nevrací se
+}
+
+void MLX90641::workerLoop()
+{
+    workerRunning = true;
+
+    // Ověření cache kalibrace ještě před první akvizicí - boot na ně
+    // nečeká a první frame vznikne už ze správných parametrů
+    if (calVerifyPending)
+    {
+        verifyCalibration();
+    }
+
+    while (true)
+    {
+        // Krátké dotazy na status registr místo busy-waitu v GetFrameData,
+        // aby se I2C mutex nedržel po stovky milisekund
+        if (!dataReady())
+        {
+            sleep_ms(5);
+            continue;
+        }
+
+        uint8_t back = 1 - frontIndex;
+        if (acquireAndCompute(frameBuffers[back]))
+        {
+            publishBackBuffer();
+        }
+        else
+        {
+            sleep_ms(20);
+        }
+    }
+}
+
+void MLX90641::publishBackBuffer()
+{
+    // Publikace: přepnutí front bufferu a inkrement čítače.
+    // 32bit zápisy jsou na M0+ atomické, core0 čte čítač před kopií.
+    // Nevyzvednutý předchozí frame tímto mizí - započítat jako dropnutý.
+    if (producedFrames != consumedFrames)
+    {
+        framesDropped = framesDropped + 1;
+    }
+    frameBuffers[1 - frontIndex].t_us = micros();
+    frontIndex = 1 - frontIndex;
+    producedFrames = producedFrames + 1;
+}
+
+bool MLX90641::workerActive() const
+{
+    return workerRunning;
+}
+
+void MLX90641::poll()
+{
+    // workerStartRequested kryje i okno mezi startWorker() a prvním
+    // průchodem loop1, kdy workerRunning ještě není nastavené
+    if (!initialized || workerRunning || workerStartRequested)
+    {
+        return;
+    }
+
+    // Single-core režim: ověření cache proběhne v prvním poll()
+    if (calVerifyPending)
+    {
+        verifyCalibration();
+        return;
+    }
+
+    switch (acqState)
+    {
+    case ACQ_WAIT_DATA:
+    {
+        // Jediné krátké čtení status registru za iteraci loop() -
+        // žádný busy-wait jako v MLX90641_GetFrameData
+        uint16_t statusReg = 0;
+        if (MLX90641_I2CRead(MLX90641_I2C_ADDR, 0x8000, 1, &statusReg) != 0)
+        {
+            return;
+        }
+        if ((statusReg & 0x0008) == 0)
+        {
+            return;
+        }
+        acqSubPage = statusReg & 0x0001;
+
+        // Smazat new-data bit, aby šlo na konci detekovat přepis během čtení
+        if (MLX90641_I2CWrite(MLX90641_I2C_ADDR, 0x8000, 0x0030) != 0)
+        {
+            return;
+        }
+        acqWordsRead = 0;
+        acqState = ACQ_READ_FRAME;
+        break;
+    }
+
+    case ACQ_READ_FRAME:
+    {
+        // Stejné adresování jako MLX90641_GetFrameData: pixelové řádky
+        // obou subpage se v RAM střídají po 16 slovech (subpage 0 na
+        // 0x0400 + 0x20*řádek, subpage 1 o 0x10 výš), takže se čte
+        // jeden 16slovový řádek (~0.9 ms na 400 kHz) za poll. Po 12
+        // řádcích následuje aux blok 0x0580-0x05AF (Ta_Vbe, CP, GAIN,
+        // Ta_PTAT, VDDpix) do frameData[192..239].
+        const uint16_t PIXEL_WORDS = 192;
+        if (acqWordsRead < PIXEL_WORDS)
+        {
+            uint16_t row = acqWordsRead / 16;
+            uint16_t addr = (uint16_t)((acqSubPage ? 0x0410 : 0x0400) +
+                                       0x20 * row);
+            if (MLX90641_I2CRead(MLX90641_I2C_ADDR, addr, 16,
+                                 frameData + acqWordsRead) != 0)
+            {
+                acqErrors = acqErrors + 1;
+                acqState = ACQ_WAIT_DATA;
+                return;
+            }
+            acqWordsRead += 16;
+        }
+        else
+        {
+            if (MLX90641_I2CRead(MLX90641_I2C_ADDR, 0x0580, 48,
+                                 frameData + PIXEL_WORDS) != 0)
+            {
+                acqErrors = acqErrors + 1;
+                acqState = ACQ_WAIT_DATA;
+                return;
+            }
+            acqState = ACQ_FINISH;
+        }
+        break;
+    }
+
+    case ACQ_FINISH:
+    {
+        // Pokud se během čtení stihl připravit další subpage, byl frame
+        // pravděpodobně přepsaný - zahodit a začít znovu
+        uint16_t statusReg = 0;
+        if (MLX90641_I2CRead(MLX90641_I2C_ADDR, 0x8000, 1, &statusReg) != 0 ||
+            (statusReg & 0x0008) != 0)
+        {
+            // Zachycený, ale přepsaný frame = dropnutý
+            framesDropped = framesDropped + 1;
+            acqState = ACQ_WAIT_DATA;
+            return;
+        }
+
+        uint16_t controlReg = 0;
+        if (MLX90641_I2CRead(MLX90641_I2C_ADDR, 0x800D, 1, &controlReg) != 0)
+        {
+            acqState = ACQ_WAIT_DATA;
+            return;
+        }
+        frameData[240] = controlReg;
+        frameData[241] = acqSubPage;
+        noteSubpage(acqSubPage);
+
+        // Výpočet To[] do zadního bufferu a publikace
+        MLX90641Frame &back = frameBuffers[1 - frontIndex];
+        back.vdd = MLX90641_GetVdd(frameData, &calibration);
+        back.ta = MLX90641_GetTa(frameData, &calibration);
+
+        float emissivity = MLX90641_GetEmissivity(&calibration);
+        float tr = back.ta - 5.0f;
+        if (fastTablesReady)
+        {
+            calculateToFast(back.vdd, back.ta, emissivity, tr, back.map);
+        }
+        else
+        {
+            MLX90641_CalculateTo(frameData, &calibration, emissivity, tr, back.map);
+        }
+
+        publishBackBuffer();
+        acqState = ACQ_WAIT_DATA;
+        break;
+    }
+    }
+}
+
+bool MLX90641::startWorker()
+{
+    if (!initialized || workerRunning)
+    {
+        return workerRunning;
+    }
+
+    // Core1 startuje framework (setup1/loop1 v main.cpp), tady se jen
+    // zvedne požadavek. Přímé multicore_launch_core1 by framework
+    // obešlo a zápisy do flash z core0 (EEPROM.commit, LittleFS) by
+    // neměly jak core1 uspat - core1 by při erase/program dál
+    // vykonávalo kód z XIP flash.
+    workerStartRequested = true;
+    if (!multidrop_active)
+    {
+        Serial.println("# MLX90641 worker started on core1");
+    }
+    return true;
+}
+
+bool MLX90641::frameReady() const
+{
+    return producedFrames != consumedFrames;
+}
+
+bool MLX90641::getThermalData(float &vdd, float &ta, float corners[4], float &center)
+{
+    if (!frameReady())
+    {
+        return false;
+    }
+
+    // Kopie front bufferu; pokud worker mezitím publikoval další frame,
+    // kopii opakujeme (frame je ~780 B, kopie trvá jednotky mikrosekund)
+    uint32_t counter;
+    do
+    {
+        counter = producedFrames;
+        const MLX90641Frame &front = frameBuffers[frontIndex];
+        vdd = front.vdd;
+        ta = front.ta;
+        lastFrameUs = front.t_us;
+        memcpy(temperatureMap, front.map, sizeof(temperatureMap));
+    } while (counter != producedFrames);
+
+    consumedFrames = counter;
+    hasValidFrame = true;
+
+    computeStats();
+    for (int i = 0; i < 4; ++i)
+    {
+        corners[i] = stats.regions[i].mean;
+    }
+    center = stats.regions[4].mean;
+    return true;
+}
+
 bool MLX90641::readThermalData(float &vdd, float &ta, float corners[4], float &center)
 {
     if (!initialized)
@@ -88,59 +717,131 @@ bool MLX90641::readThermalData(float &vdd, float &ta, float corners[4], float &c
 
     vdd = MLX90641_GetVdd(frameData, &calibration);
     ta = MLX90641_GetTa(frameData, &calibration);
+    lastFrameUs = micros();
 
     // Emisivita z EEPROM, odražená teplota přibližně Ta-5°C dle datasheetu
     float emissivity = MLX90641_GetEmissivity(&calibration);
     float tr = ta - 5.0f;
 
     // Spočítá teplotu objektu pro všech 192 pixelů
-    MLX90641_CalculateTo(frameData, &calibration, emissivity, tr, temperatureMap);
+    if (fastTablesReady)
+    {
+        calculateToFast(vdd, ta, emissivity, tr, temperatureMap);
+    }
+    else
+    {
+        MLX90641_CalculateTo(frameData, &calibration, emissivity, tr, temperatureMap);
+    }
     hasValidFrame = true;
 
-    // Spočítat rohy a střed z mapy
-    computeRegions(corners, center);
+    // Spočítat rohy a střed z mapy (a kompletní statistiku framu)
+    computeStats();
+    for (int i = 0; i < 4; ++i)
+    {
+        corners[i] = stats.regions[i].mean;
+    }
+    center = stats.regions[4].mean;
 
     return true;
 }
 
-void MLX90641::computeRegions(float corners[4], float &center) const
+void MLX90641::computeStats()
 {
+    constexpr int rows = 12;  // MLX90641 má 12 řádků
+    constexpr int cols = 16;  // a 16 sloupců
+
+    // Akumulátory: 5 oblastí (TL, TR, BL, BR, CTR) + celá mapa
+    float sum[6] = {0};
+    float sumSq[6] = {0};
+    float minV[6];
+    float maxV[6];
+    int count[6] = {0};
+    for (int i = 0; i < 6; ++i)
+    {
+        minV[i] = INFINITY;
+        maxV[i] = -INFINITY;
+    }
+
+    for (int i = 0; i < ThermalStats::HIST_BUCKETS; ++i)
+    {
+        stats.histogram[i] = 0;
+    }
+
     if (!hasValidFrame)
     {
-        for (int i = 0; i < 4; ++i)
+        for (int i = 0; i < 5; ++i)
         {
-            corners[i] = NAN;
+            stats.regions[i] = {NAN, NAN, NAN, NAN};
         }
-        center = NAN;
+        stats.map = {NAN, NAN, NAN, NAN};
         return;
     }
 
-    constexpr int rows = 12;  // MLX90641 má 12 řádků
-    constexpr int cols = 16;  // a 16 sloupců
+    // Jediný průchod všemi pixely; příslušnost k 4×4 oknům se určuje
+    // porovnáním řádku/sloupce, žádné vnořené smyčky přes okna
+    for (int idx = 0; idx < MLX90641_PIXEL_COUNT; ++idx)
+    {
+        int r = idx / cols;
+        int c = idx % cols;
+        float v = temperatureMap[idx];
 
-    auto regionAvg = [&](int r0, int r1, int c0, int c1) {
-        float sum = 0.0f;
-        int count = 0;
-        for (int r = r0; r <= r1; ++r)
+        int region = -1;
+        if (r < 4)
         {
-            for (int c = c0; c <= c1; ++c)
-            {
-                int idx = r * cols + c;
-                sum += temperatureMap[idx];
-                ++count;
-            }
+            if (c < 4) region = 0;                 // TL
+            else if (c >= cols - 4) region = 1;    // TR
+        }
+        else if (r >= rows - 4)
+        {
+            if (c < 4) region = 2;                 // BL
+            else if (c >= cols - 4) region = 3;    // BR
+        }
+        if (r >= 4 && r <= 7 && c >= 6 && c <= 9)
+        {
+            region = 4;                            // CTR (nepřekrývá rohy)
         }
-        return (count > 0) ? (sum / count) : NAN;
-    };
 
-    // 4×4 oblasti v rozích
-    corners[0] = regionAvg(0, 3, 0, 3);           // TL
-    corners[1] = regionAvg(0, 3, cols - 4, cols - 1); // TR
-    corners[2] = regionAvg(rows - 4, rows - 1, 0, 3); // BL
-    corners[3] = regionAvg(rows - 4, rows - 1, cols - 4, cols - 1); // BR
+        if (region >= 0)
+        {
+            sum[region] += v;
+            sumSq[region] += v * v;
+            if (v < minV[region]) minV[region] = v;
+            if (v > maxV[region]) maxV[region] = v;
+            ++count[region];
+        }
+
+        sum[5] += v;
+        sumSq[5] += v * v;
+        if (v < minV[5]) minV[5] = v;
+        if (v > maxV[5]) maxV[5] = v;
+        ++count[5];
+
+        // Histogram: přihrádky po 10 °C od -40 °C, krajní zachytí zbytek
+        int bucket = (int)((v + 40.0f) * 0.1f);
+        if (bucket < 0) bucket = 0;
+        if (bucket >= ThermalStats::HIST_BUCKETS) bucket = ThermalStats::HIST_BUCKETS - 1;
+        ++stats.histogram[bucket];
+    }
 
-    // Středová oblast 4×4
-    center = regionAvg(4, 7, 6, 9);
+    auto finish = [&](int i) {
+        ThermalRegionStats out;
+        if (count[i] == 0)
+        {
+            return ThermalRegionStats{NAN, NAN, NAN, NAN};
+        }
+        out.mean = sum[i] / count[i];
+        out.min = minV[i];
+        out.max = maxV[i];
+        float var = sumSq[i] / count[i] - out.mean * out.mean;
+        out.stddev = (var > 0.0f) ? sqrtf(var) : 0.0f;
+        return out;
+    };
+
+    for (int i = 0; i < 5; ++i)
+    {
+        stats.regions[i] = finish(i);
+    }
+    stats.map = finish(5);
 }
 
 const float *MLX90641::getTemperatureMap() const
@@ -148,3 +849,57 @@ const float *MLX90641::getTemperatureMap() const
     return hasValidFrame ? temperatureMap : nullptr;
 }
 
+bool MLX90641::benchCompute(uint32_t iters, uint32_t &refCycles,
+                            uint32_t &fastCycles, uint32_t &statsCycles)
+{
+    if (!initialized || !hasValidFrame || iters == 0)
+    {
+        return false;
+    }
+
+    // Kopie framu: worker na core1 může frameData průběžně přepisovat,
+    // benchmark musí počítat nad stabilním vstupem
+    static uint16_t frame[242];
+    static float to[MLX90641_PIXEL_COUNT];
+    memcpy(frame, (const void *)frameData, sizeof(frame));
+
+    float vdd = MLX90641_GetVdd(frame, &calibration);
+    float ta = MLX90641_GetTa(frame, &calibration);
+    float emissivity = MLX90641_GetEmissivity(&calibration);
+    float tr = ta - 5.0f;
+    (void)vdd;
+
+    // Referenční výpočet z oficiální knihovny
+    uint32_t t0 = rp2040.getCycleCount();
+    for (uint32_t i = 0; i < iters; i++)
+    {
+        MLX90641_CalculateTo(frame, &calibration, emissivity, tr, to);
+    }
+    refCycles = (rp2040.getCycleCount() - t0) / iters;
+
+    // Rychlá varianta nad předpočítanými tabulkami
+    if (fastTablesReady)
+    {
+        t0 = rp2040.getCycleCount();
+        for (uint32_t i = 0; i < iters; i++)
+        {
+            calculateToFast(vdd, ta, emissivity, tr, to);
+        }
+        fastCycles = (rp2040.getCycleCount() - t0) / iters;
+    }
+    else
+    {
+        fastCycles = 0;
+    }
+
+    // Statistika nad poslední platnou mapou (stats se přepíše stejnými
+    // hodnotami, taskThermal běží na stejném jádře - žádný souběh)
+    t0 = rp2040.getCycleCount();
+    for (uint32_t i = 0; i < iters; i++)
+    {
+        computeStats();
+    }
+    statsCycles = (rp2040.getCycleCount() - t0) / iters;
+
+    return true;
+}
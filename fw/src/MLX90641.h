@@ -10,6 +10,43 @@
 #define MLX90641_I2C_ADDR 0x33
 #define MLX90641_PIXEL_COUNT 192
 
+// Takt sběrnice v kHz; 1000 (fast-mode plus) jen s vhodnými pull-upy
+#ifndef MLX_I2C_KHZ
+#define MLX_I2C_KHZ 400
+#endif
+
+// Výběr sběrnice pro Arduino I2C driver (MLX90641_I2C_Arduino.cpp);
+// volá se z begin() podle předané Wire instance
+void MLX90641_I2CSetWire(TwoWire *wire);
+
+// Kompletní zpracovaný frame předávaný z core1 na core0
+struct MLX90641Frame {
+    float vdd;
+    float ta;
+    float map[MLX90641_PIXEL_COUNT];
+    uint32_t t_us;  // micros() v okamžiku dokončení framu
+};
+
+// Statistika jedné oblasti (roh/střed/celá mapa)
+struct ThermalRegionStats {
+    float mean;
+    float min;
+    float max;
+    float stddev;
+};
+
+// Výsledek jednoprůchodové redukce nad teplotní mapou
+struct ThermalStats {
+    // Pořadí: TL, TR, BL, BR, CTR (stejné jako v $cloud)
+    ThermalRegionStats regions[5];
+    ThermalRegionStats map;       // celá mapa
+
+    // Histogram s pevnými přihrádkami po 10 °C v rozsahu -40..+40 °C
+    // (hodnoty mimo rozsah padají do krajních přihrádek)
+    static const int HIST_BUCKETS = 8;
+    uint16_t histogram[HIST_BUCKETS];
+};
+
 class MLX90641 {
 private:
     TwoWire* _wire;
@@ -24,7 +61,98 @@ private:
     // Poslední vypočtená teplotní mapa (°C) pro všech 192 pixelů
     float temperatureMap[MLX90641_PIXEL_COUNT];
 
-    void computeRegions(float corners[4], float &center) const;
+    // Časové razítko naposledy vyzvednutého framu (pro měření latence
+    // měření -> trigger výstup)
+    uint32_t lastFrameUs;
+
+    // Předpočítané kalibrační tabulky pro rychlý výpočet To[].
+    // Kalibrace je po ExtractParameters neměnná, takže převody škál
+    // (2^ktaScale apod.) a převrácené alfa stačí spočítat jednou v begin().
+    float fastInvAlpha[MLX90641_PIXEL_COUNT]; // SCALEALPHA*2^alphaScale/alpha[i]
+    float fastKta[MLX90641_PIXEL_COUNT];      // kta[i]/2^ktaScale
+    float fastKv[MLX90641_PIXEL_COUNT];       // kv[i]/2^kvScale
+    float fastOffset[2][MLX90641_PIXEL_COUNT]; // offset podle subpage
+    float fastAlphaCorr[8];                    // korekce rozsahů z ksTo/ct
+    bool fastTablesReady;
+
+    void buildFastTables();
+
+    // Cache extrahované kalibrace v LittleFS (soubor /mlx_cal.bin).
+    // Klíčem jsou ID slova senzoru + CRC16 celé EEPROM; při warm bootu
+    // se kalibrace načte ze souboru bez čtení 832 slov po I2C a plný
+    // dump se ověří až na pozadí (workerem, případně v prvním poll()).
+    uint16_t calCrc;
+    volatile bool calVerifyPending;
+    volatile bool calCacheDirty;
+
+    bool loadCalibrationCache();
+    void saveCalibrationCache();
+    void verifyCalibration();
+
+    // Rychlá varianta MLX90641_CalculateTo nad předpočítanými tabulkami:
+    // na pixel zbývá jen pár násobení/sečtení a dvě sqrtf (čtvrtá odmocnina)
+    void calculateToFast(float vdd, float ta, float emissivity, float tr,
+                         float *result);
+
+    // Double buffer pro dual-core pipeline: core1 plní zadní buffer,
+    // po dokončení atomicky přepne frontIndex a zvedne čítač snímků.
+    MLX90641Frame frameBuffers[2];
+    volatile uint8_t frontIndex;
+    volatile uint32_t producedFrames;
+    uint32_t consumedFrames;
+    volatile bool workerRunning;
+
+    // Stavový automat neblokující akvizice (když neběží worker na core1)
+    enum AcqState {
+        ACQ_WAIT_DATA,   // čekání na nový subpage (1 čtení status registru za poll)
+        ACQ_READ_FRAME,  // postupné čtení RAM po malých blocích
+        ACQ_FINISH       // kontrola konzistence, control registr, výpočet To[]
+    };
+    AcqState acqState;
+    uint16_t acqWordsRead;
+    uint16_t acqSubPage;
+
+    // Refresh rate (kód registru dle datasheetu: 0b011 = 4 Hz,
+    // 0b101 = 16 Hz); nastavitelný za běhu přes setRefreshRate()
+    uint8_t refreshCode;
+
+    // Účetnictví snímků: u MLX90641 nese každý subpage kompletní mapu
+    // (offsety jsou per subpage), takže zpracování je už per-subpage.
+    // Čítače odhalí, co se přesto ztratilo:
+    //  framesDropped  - publikovaný frame přepsaný dřív, než si ho core0
+    //                   vyzvedl (nebo zahozený kvůli přepisu při čtení)
+    //  subpageMisses  - dva stejné subpage po sobě = jeden prošvihnutý
+    //  acqErrors      - I2C chyby při akvizici
+    volatile uint32_t framesDropped;
+    volatile uint32_t subpageMisses;
+    volatile uint32_t acqErrors;
+    int8_t lastSubpage;
+
+    // Detekce prošvihnutého subpage z čísla právě přečteného
+    void noteSubpage(uint16_t subPage);
+
+    // Statistika posledního framu (plní computeStats)
+    ThermalStats stats;
+
+    // Jediný průchod mapou: průměr/min/max/stddev pro rohy, střed i celou
+    // mapu plus histogram - nahrazuje původní computeRegions s vnořenými
+    // smyčkami přes okna
+    void computeStats();
+
+    // Publikace zadního bufferu (volá worker i poll())
+    void publishBackBuffer();
+
+    // Smyčka workeru na core1 (vstup přes workerRun z loop1())
+    void workerLoop();
+
+    // startWorker() požádal o spuštění workeru (loop1 na něj čeká)
+    volatile bool workerStartRequested;
+
+    // Přečte status registr; vrací true pokud je k dispozici nový subpage
+    bool dataReady();
+
+    // Jedno kompletní načtení a přepočet framu do zadního bufferu
+    bool acquireAndCompute(MLX90641Frame &out);
 
 public:
     MLX90641();
@@ -35,11 +163,72 @@ public:
     // Dostupnost senzoru (úspěšná inicializace)
     bool isAvailable() const;
 
-    // Načte nový frame, spočítá Vdd, Ta, celou mapu To[] a rohové/středové průměry
+    // Požádá o spuštění akvizičního workeru na core1 (akvizice +
+    // CalculateTo mimo loop()); samotné tělo běží ve frameworkovém
+    // loop1(), viz workerRun()
+    bool startWorker();
+
+    // Tělo workeru pro loop1() v main.cpp. Core1 musí startovat
+    // framework (setup1/loop1), ne přímé multicore_launch_core1 - jen
+    // tak umí jádro při zápisech do flash (EEPROM, LittleFS) core1
+    // bezpečně uspat, místo aby dál fetchovalo z XIP flash uprostřed
+    // erase. Do požadavku startWorker() jen krátce spí a vrací se;
+    // po něm přejde do workerLoop() a už se nevrátí.
+    void workerRun();
+
+    // Běží akviziční worker na core1?
+    bool workerActive() const;
+
+    // Neblokující akvizice řízená z loop(): jedno volání = jeden malý krok
+    // (kontrola status registru nebo čtení jednoho bloku RAM). Po dokončení
+    // framu je výsledek dostupný přes frameReady()/getThermalData().
+    // Když běží worker na core1, nedělá nic.
+    void poll();
+
+    // Je k dispozici nový frame z workeru, který ještě nebyl vyzvednut?
+    bool frameReady() const;
+
+    // Vyzvedne poslední dokončený frame z workeru: zkopíruje mapu,
+    // spočítá rohy/střed a vrátí Vdd/Ta. Neblokuje na I2C.
+    bool getThermalData(float &vdd, float &ta, float corners[4], float &center);
+
+    // Synchronní čtení (bez workeru) - načte nový frame, spočítá Vdd, Ta,
+    // celou mapu To[] a rohové/středové průměry
     bool readThermalData(float &vdd, float &ta, float corners[4], float &center);
 
     // Vrací pointer na poslední platnou teplotní mapu (nebo nullptr pokud není)
     const float *getTemperatureMap() const;
+
+    // Statistika posledního framu (platná po úspěšném getThermalData /
+    // readThermalData)
+    const ThermalStats &getThermalStats() const { return stats; }
+
+    // micros() dokončení naposledy vyzvednutého framu
+    uint32_t lastFrameMicros() const { return lastFrameUs; }
+
+    // Servis cache kalibrace: zápis do flash po ověření na pozadí.
+    // Volat z core0 (flash zápisy nechceme z core1), stačí jednou za pár ms.
+    void serviceCalibrationCache();
+
+    // Mikrobenchmark výpočetních jader (příkaz "bench" v main.cpp):
+    // referenční MLX90641_CalculateTo z knihovny, rychlá varianta
+    // calculateToFast a jednoprůchodová statistika computeStats, vše nad
+    // kopií posledního reálného framu a skutečnou kalibrací. Výstupem
+    // jsou cykly na jednu operaci; vrací false bez platného framu.
+    bool benchCompute(uint32_t iters, uint32_t &refCycles,
+                      uint32_t &fastCycles, uint32_t &statsCycles);
+
+    // Nastavení refresh rate (kód 0-7 dle datasheetu); lze volat i za
+    // běhu workeru - zápis registru jde přes zámek MLX sběrnice
+    // (sdílený amskyI2cMutex, na vlastním řadiči mutex driveru)
+    bool setRefreshRate(uint8_t code);
+    uint8_t refreshRateCode() const { return refreshCode; }
+
+    // Čítače pro $mlxstats - poctivé účetnictví toho, co se zachytilo
+    uint32_t producedCount() const { return producedFrames; }
+    uint32_t droppedCount() const { return framesDropped; }
+    uint32_t subpageMissCount() const { return subpageMisses; }
+    uint32_t acqErrorCount() const { return acqErrors; }
 };
 
 #endif
@@ -1,30 +1,79 @@
 #include <Arduino.h>
 #include <Wire.h>
+#include <pico/mutex.h>
 
 #include "mlx90641-library/headers/MLX90641_I2C_Driver.h"
+#include "i2c_lock.h"
 
-// Používáme I2C sběrnici Wire1, která je v main.cpp nakonfigurovaná
+// Výchozí je sdílená sběrnice Wire1 (konfigurovaná v main.cpp); přes
+// MLX90641_I2CSetWire lze kameru přesunout na vlastní řadič (Wire/I2C0),
+// takže velká čtení framů neserializují za SHT4x/TSL2591 transakcemi
 extern TwoWire Wire1;
 
-static TwoWire &mlxWire = Wire1;
+static TwoWire *mlxWire = &Wire1;
+
+// Na sdílené Wire1 kryje transakce společný amskyI2cMutex. Vlastní
+// řadič má mutex vlastní - sběrnice je sice vyhrazená kameře, ale při
+// běžícím workeru na ni pořád sahají obě jádra (čtení framů z core1
+// vs. zápis refresh rate z core0 přes "set mlx_refresh"), takže bez
+// zámku by se transakce na téže TwoWire instanci proplétaly
+static bool mlxSharedBus = true;
+static mutex_t mlxOwnBusMutex;
+static bool mlxOwnBusMutexReady = false;
+
+void MLX90641_I2CSetWire(TwoWire *wire)
+{
+    mlxWire = (wire != nullptr) ? wire : &Wire1;
+    mlxSharedBus = (mlxWire == &Wire1);
+}
+
+static inline void mlxBusLock()
+{
+    if (mlxSharedBus)
+    {
+        amskyI2cLock();
+    }
+    else
+    {
+        mutex_enter_blocking(&mlxOwnBusMutex);
+    }
+}
+
+static inline void mlxBusUnlock()
+{
+    if (mlxSharedBus)
+    {
+        amskyI2cUnlock();
+    }
+    else
+    {
+        mutex_exit(&mlxOwnBusMutex);
+    }
+}
 
 void MLX90641_I2CInit(void)
 {
-    // Inicializace a piny se řeší v uživatelském kódu (main.cpp)
+    // Piny a inicializace řadiče se řeší v uživatelském kódu
+    // (main.cpp); tady se jen založí mutex pro případ vlastního řadiče
+    if (!mlxOwnBusMutexReady)
+    {
+        mutex_init(&mlxOwnBusMutex);
+        mlxOwnBusMutexReady = true;
+    }
 }
 
 void MLX90641_I2CFreqSet(int freq)
 {
     // freq je v kHz
-    mlxWire.setClock((uint32_t)freq * 1000U);
+    mlxWire->setClock((uint32_t)freq * 1000U);
 }
 
 int MLX90641_I2CGeneralReset(void)
 {
     // General Call reset (adresa 0x00, data 0x06)
-    mlxWire.beginTransmission(0x00);
-    mlxWire.write(0x06);
-    uint8_t res = mlxWire.endTransmission();
+    mlxWire->beginTransmission(0x00);
+    mlxWire->write(0x06);
+    uint8_t res = mlxWire->endTransmission();
     delay(5);
     return (res == 0) ? 0 : -1;
 }
@@ -33,7 +82,14 @@ int MLX90641_I2CRead(uint8_t slaveAddr, uint16_t startAddress,
                      uint16_t nMemAddressRead, uint16_t *data)
 {
     const uint8_t addr = slaveAddr; // Arduino používá 7bit adresu
-    const uint16_t MAX_WORDS_PER_CHUNK = 16; // 16 slov = 32 bajtů (I2C buffer)
+
+    // 64 slov = 128 bajtů na burst (velikost Wire bufferu v core).
+    // Větší bloky znamenají méně start/stop režie na frame: 242 slov
+    // přečteme ve 4 burstech místo 16.
+    const uint16_t MAX_WORDS_PER_CHUNK = 64;
+
+    // Sběrnici sdílíme s SHT4x/TSL2591 na druhém jádru
+    mlxBusLock();
 
     uint16_t wordsRead = 0;
 
@@ -45,36 +101,39 @@ int MLX90641_I2CRead(uint8_t slaveAddr, uint16_t startAddress,
 
         uint16_t currentAddress = startAddress + wordsRead;
 
-        mlxWire.beginTransmission(addr);
-        mlxWire.write(currentAddress >> 8);
-        mlxWire.write(currentAddress & 0xFF);
-        if (mlxWire.endTransmission(false) != 0)
+        mlxWire->beginTransmission(addr);
+        mlxWire->write(currentAddress >> 8);
+        mlxWire->write(currentAddress & 0xFF);
+        if (mlxWire->endTransmission(false) != 0)
         {
+            mlxBusUnlock();
             return -1;
         }
 
-        uint8_t toRead = (uint8_t)(chunkWords * 2);
-        uint8_t received = mlxWire.requestFrom(addr, toRead);
+        size_t toRead = (size_t)chunkWords * 2;
+        size_t received = mlxWire->requestFrom(addr, toRead);
         if (received != toRead)
         {
+            mlxBusUnlock();
             return -1;
         }
 
         for (uint16_t i = 0; i < chunkWords; ++i)
         {
-            int hi = mlxWire.read();
-            int lo = mlxWire.read();
+            int hi = mlxWire->read();
+            int lo = mlxWire->read();
             if (hi < 0 || lo < 0)
             {
+                mlxBusUnlock();
                 return -1;
             }
             data[wordsRead + i] = (uint16_t)((hi << 8) | lo);
         }
 
         wordsRead += chunkWords;
-        delay(2); // krátká pauza mezi bloky
     }
 
+    mlxBusUnlock();
     return 0;
 }
 
@@ -82,12 +141,14 @@ int MLX90641_I2CWrite(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data)
 {
     const uint8_t addr = slaveAddr;
 
-    mlxWire.beginTransmission(addr);
-    mlxWire.write(writeAddress >> 8);
-    mlxWire.write(writeAddress & 0xFF);
-    mlxWire.write(data >> 8);
-    mlxWire.write(data & 0xFF);
-    uint8_t res = mlxWire.endTransmission();
+    mlxBusLock();
+    mlxWire->beginTransmission(addr);
+    mlxWire->write(writeAddress >> 8);
+    mlxWire->write(writeAddress & 0xFF);
+    mlxWire->write(data >> 8);
+    mlxWire->write(data & 0xFF);
+    uint8_t res = mlxWire->endTransmission();
+    mlxBusUnlock();
 
     if (res != 0)
     {
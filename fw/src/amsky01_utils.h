@@ -21,4 +21,25 @@ String getDeviceSerialNumber() {
     return String(serial);
 }
 
+/**
+ * Derive the short multi-drop bus address from the RP2040 unique ID.
+ * XOR-fold of the 8 ID bytes; 0x00 (unaddressed) and 0xFF (broadcast)
+ * are reserved and remapped, so the result is always a valid unit
+ * address. Collisions on a 6-unit bus are unlikely but possible -
+ * check the $HELLO output when commissioning a chain.
+ */
+uint8_t getBusAddress() {
+    pico_unique_board_id_t board_id;
+    pico_get_unique_board_id(&board_id);
+
+    uint8_t addr = 0;
+    for (int i = 0; i < 8; i++) {
+        addr ^= board_id.id[i];
+    }
+    if (addr == 0x00 || addr == 0xFF) {
+        addr = 0x01;
+    }
+    return addr;
+}
+
 #endif // AMSKY01_UTILS_H
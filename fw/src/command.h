@@ -0,0 +1,205 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <Arduino.h>
+#include "telemetry.h"
+
+/**
+ * Serial command subsystem: hashed dispatch + streaming line assembler.
+ *
+ * Commands are described by a static table of CmdEntry; the name hash
+ * is computed at compile time (constexpr FNV-1a), so dispatch is one
+ * hash of the received token and a scan over 32-bit integers, with a
+ * single strcmp to confirm on hash match. Adding a command is one table
+ * line - no growing strcmp chain in the hot path.
+ *
+ * RX side: bytes are pulled into a 512 B ring and assembled into lines
+ * of up to 128 chars, so a calibration script bursting "set" commands
+ * no longer overflows the old 64-byte stack buffer and loses bytes.
+ * Tokenization is zero-copy: the line is split in place and handlers
+ * receive pointers into the assembler's buffer.
+ *
+ * Multi-drop mode (setBusAddress): commands must be prefixed with
+ * "@<hex-addr> " - only lines addressed to this unit (or to the 0xFF
+ * broadcast address) are dispatched, everything else on the shared bus
+ * is ignored without any reply. This is the listen half of the
+ * quiet/listen discipline; the transmit half (telemetry only when
+ * polled) lives in main.cpp.
+ */
+
+// FNV-1a, usable in constexpr context for the table initializers
+constexpr uint32_t cmdHash(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Zero-copy tokenizer over the assembled command line
+class CmdArgs {
+private:
+    char *cursor;
+
+public:
+    explicit CmdArgs(char *rest) : cursor(rest) {}
+
+    // Next whitespace-delimited token, NUL-terminated in place;
+    // nullptr when the line is exhausted
+    char *next() {
+        if (cursor == nullptr) {
+            return nullptr;
+        }
+        while (*cursor == ' ') {
+            cursor++;
+        }
+        if (*cursor == '\0') {
+            return nullptr;
+        }
+        char *tok = cursor;
+        while (*cursor != '\0' && *cursor != ' ') {
+            cursor++;
+        }
+        if (*cursor != '\0') {
+            *cursor++ = '\0';
+        }
+        return tok;
+    }
+};
+
+struct CmdEntry {
+    uint32_t hash;
+    const char *name;
+    void (*fn)(CmdArgs &args);
+};
+
+// Table line helper keeps the hash and the confirming name in sync
+#define CMD_ENTRY(name, fn) { cmdHash(name), name, fn }
+
+class CommandProcessor {
+private:
+    static const size_t RX_RING = 512;
+    static const size_t LINE_MAX = 128;
+
+    const CmdEntry *table;
+    uint8_t table_len;
+
+    uint8_t ring[RX_RING];
+    size_t head;
+    size_t tail;
+    size_t used;
+    uint32_t overruns;
+
+    char line[LINE_MAX];
+    size_t line_len;
+    bool line_overflow;
+
+    // Multi-drop filter; 0 = point-to-point, every line is ours
+    uint8_t bus_addr;
+
+    static int hexNibble(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    // Strip and check the "@HH " address prefix; returns the command
+    // itself when the line is for this unit, nullptr otherwise
+    char *addressed(char *l) {
+        if (bus_addr == 0) {
+            return l;
+        }
+        if (l[0] != '@') {
+            return nullptr;
+        }
+        int hi = hexNibble(l[1]);
+        int lo = hexNibble(l[2]);
+        if (hi < 0 || lo < 0 || (l[3] != ' ' && l[3] != '\0')) {
+            return nullptr;
+        }
+        uint8_t addr = (uint8_t)((hi << 4) | lo);
+        if (addr != bus_addr && addr != 0xFF) {
+            return nullptr;
+        }
+        return l + 3;
+    }
+
+    void dispatch(char *l) {
+        CmdArgs args(l);
+        char *cmd = args.next();
+        if (cmd == nullptr) {
+            return;
+        }
+
+        uint32_t h = cmdHash(cmd);
+        for (uint8_t i = 0; i < table_len; i++) {
+            if (table[i].hash == h && strcmp(table[i].name, cmd) == 0) {
+                table[i].fn(args);
+                return;
+            }
+        }
+        Serial.print("# Unknown command: "); Serial.println(cmd);
+    }
+
+public:
+    CommandProcessor(const CmdEntry *entries, uint8_t count)
+        : table(entries), table_len(count), head(0), tail(0), used(0),
+          overruns(0), line_len(0), line_overflow(false), bus_addr(0) {}
+
+    // Enable the multi-drop address filter (0 turns it back off)
+    void setBusAddress(uint8_t addr) {
+        bus_addr = addr;
+    }
+
+    // Pull pending bytes, assemble lines, dispatch complete commands.
+    // Command replies go straight to Serial, so the TX ring is flushed
+    // before each dispatch to keep lines from interleaving.
+    void poll() {
+        while (Serial.available() > 0 && used < RX_RING) {
+            ring[head] = (uint8_t)Serial.read();
+            head = (head + 1) % RX_RING;
+            used++;
+        }
+        if (Serial.available() > 0 && used >= RX_RING) {
+            // Ring full with unconsumed data - count it, keep the oldest
+            while (Serial.available() > 0) {
+                Serial.read();
+                overruns++;
+            }
+        }
+
+        while (used > 0) {
+            char c = (char)ring[tail];
+            tail = (tail + 1) % RX_RING;
+            used--;
+
+            if (c == '\n' || c == '\r') {
+                if (line_len > 0 && !line_overflow) {
+                    line[line_len] = '\0';
+                    // On a shared bus the flush happens only for lines
+                    // addressed to this unit - foreign traffic must not
+                    // trigger any transmission
+                    char *cmd = addressed(line);
+                    if (cmd != nullptr) {
+                        txRing.flush();
+                        dispatch(cmd);
+                    }
+                } else if (line_overflow && bus_addr == 0) {
+                    Serial.println("# Command too long, dropped");
+                }
+                line_len = 0;
+                line_overflow = false;
+            } else if (line_len < LINE_MAX - 1) {
+                line[line_len++] = c;
+            } else {
+                line_overflow = true;
+            }
+        }
+    }
+
+    uint32_t rxOverruns() const { return overruns; }
+};
+
+#endif // COMMAND_H
@@ -3,12 +3,21 @@
 
 #include <Arduino.h>
 #include <EEPROM.h>
+#include <LittleFS.h>
 
 // EEPROM size allocation
 #define EEPROM_SIZE 256
 
+// Config journal: small per-field change records appended to a LittleFS
+// file instead of rewriting the whole EEPROM block on every change.
+// When the journal outgrows JOURNAL_MAX it is compacted into a fresh
+// full snapshot. Nightly single-float calibration updates then cost a
+// few journal bytes, not a full-block erase+write.
+#define CONFIG_JOURNAL_PATH "/config.jnl"
+#define CONFIG_JOURNAL_MAX 2048
+
 // Configuration structure version - increment when changing structure
-#define CONFIG_VERSION 1
+#define CONFIG_VERSION 3
 #define CONFIG_MAGIC 0xA5CA  // Magic number to verify valid config
 
 // Configuration structure stored in EEPROM
@@ -38,15 +47,131 @@ struct DeviceConfig {
     // Measurement intervals (milliseconds)
     uint16_t measurement_interval;  // Default: 2000 ms
     
+    // MLX90641 refresh rate register code (0b011 = 4 Hz, 0b101 = 16 Hz)
+    uint8_t mlx_refresh;
+
+    // Multi-drop bus mode (RS-485 chains): address-prefixed sentences,
+    // addressed commands, transmit only when polled
+    bool multidrop;
+
     // Device identification (optional user-configurable label)
     char device_label[32];    // Custom device label/location
     
     uint16_t checksum;        // Simple checksum for data integrity
 };
 
+// Field identifiers for journal records; the dirty bitmask uses bit
+// (id - 1). Append only - ids are persisted in flash.
+enum ConfigField : uint8_t {
+    CFG_SQM_OFFSET = 1,
+    CFG_SQM_DARK_CAP,
+    CFG_SQM_OFFSET_BASE,
+    CFG_SQM_MAGNITUDE_CONST,
+    CFG_CLOUD_THRESHOLD,
+    CFG_ALERT_ENABLED,
+    CFG_ALERT_ON_CLOUD,
+    CFG_ALERT_CLOUD_TEMP,
+    CFG_ALERT_CLOUD_BELOW,
+    CFG_ALERT_ON_LIGHT,
+    CFG_ALERT_LIGHT_THR,
+    CFG_ALERT_LIGHT_ABOVE,
+    CFG_MEAS_INTERVAL,
+    CFG_DEVICE_LABEL,
+    CFG_MLX_REFRESH,
+    CFG_MULTIDROP,
+    CFG_FIELD_COUNT  // one past the last id
+};
+
 class ConfigManager {
 private:
     DeviceConfig config;
+    uint16_t dirty_mask;
+    bool fs_ok;
+
+    // Address and size of a journaled field inside the struct
+    bool fieldPtr(uint8_t id, uint8_t **ptr, uint8_t *len) {
+        switch (id) {
+            case CFG_SQM_OFFSET:         *ptr = (uint8_t*)&config.sqm_offset; *len = sizeof(float); return true;
+            case CFG_SQM_DARK_CAP:       *ptr = (uint8_t*)&config.sqm_dark_cap; *len = sizeof(float); return true;
+            case CFG_SQM_OFFSET_BASE:    *ptr = (uint8_t*)&config.sqm_offset_base; *len = sizeof(float); return true;
+            case CFG_SQM_MAGNITUDE_CONST: *ptr = (uint8_t*)&config.sqm_magnitude_const; *len = sizeof(float); return true;
+            case CFG_CLOUD_THRESHOLD:    *ptr = (uint8_t*)&config.cloud_threshold; *len = sizeof(float); return true;
+            case CFG_ALERT_ENABLED:      *ptr = (uint8_t*)&config.alert_enabled; *len = sizeof(bool); return true;
+            case CFG_ALERT_ON_CLOUD:     *ptr = (uint8_t*)&config.alert_on_cloud; *len = sizeof(bool); return true;
+            case CFG_ALERT_CLOUD_TEMP:   *ptr = (uint8_t*)&config.alert_cloud_temp_threshold; *len = sizeof(float); return true;
+            case CFG_ALERT_CLOUD_BELOW:  *ptr = (uint8_t*)&config.alert_cloud_below; *len = sizeof(bool); return true;
+            case CFG_ALERT_ON_LIGHT:     *ptr = (uint8_t*)&config.alert_on_light; *len = sizeof(bool); return true;
+            case CFG_ALERT_LIGHT_THR:    *ptr = (uint8_t*)&config.alert_light_threshold; *len = sizeof(float); return true;
+            case CFG_ALERT_LIGHT_ABOVE:  *ptr = (uint8_t*)&config.alert_light_above; *len = sizeof(bool); return true;
+            case CFG_MEAS_INTERVAL:      *ptr = (uint8_t*)&config.measurement_interval; *len = sizeof(uint16_t); return true;
+            case CFG_DEVICE_LABEL:       *ptr = (uint8_t*)config.device_label; *len = sizeof(config.device_label); return true;
+            case CFG_MLX_REFRESH:        *ptr = (uint8_t*)&config.mlx_refresh; *len = sizeof(uint8_t); return true;
+            case CFG_MULTIDROP:          *ptr = (uint8_t*)&config.multidrop; *len = sizeof(bool); return true;
+            default: return false;
+        }
+    }
+
+    // Record layout: id, len, payload, additive checksum over all three
+    static uint8_t recordChecksum(uint8_t id, uint8_t len, const uint8_t *payload) {
+        uint8_t sum = id + len;
+        for (uint8_t i = 0; i < len; i++) {
+            sum += payload[i];
+        }
+        return sum;
+    }
+
+    void markDirty(uint8_t id) {
+        dirty_mask |= (uint16_t)1 << (id - 1);
+    }
+
+    // Replay journal records over the EEPROM snapshot; stops at the
+    // first malformed record (interrupted append)
+    void journalReplay() {
+        if (!fs_ok) {
+            return;
+        }
+        File f = LittleFS.open(CONFIG_JOURNAL_PATH, "r");
+        if (!f) {
+            return;
+        }
+
+        uint16_t applied = 0;
+        while (true) {
+            uint8_t hdr[2];
+            if (f.read(hdr, 2) != 2) {
+                break;
+            }
+            uint8_t payload[sizeof(config.device_label)];
+            uint8_t cksum;
+            if (hdr[1] > sizeof(payload) ||
+                f.read(payload, hdr[1]) != hdr[1] ||
+                f.read(&cksum, 1) != 1 ||
+                cksum != recordChecksum(hdr[0], hdr[1], payload)) {
+                break;
+            }
+
+            uint8_t *ptr;
+            uint8_t len;
+            if (fieldPtr(hdr[0], &ptr, &len) && len == hdr[1]) {
+                memcpy(ptr, payload, len);
+                applied++;
+            }
+        }
+        f.close();
+
+        // Gated on the config itself: begin() runs before main.cpp has
+        // propagated the flag, and a multidrop unit must boot silently
+        if (applied > 0 && !config.multidrop) {
+            Serial.print("# Config journal replayed, records: ");
+            Serial.println(applied);
+        }
+    }
+
+    void journalClear() {
+        if (fs_ok) {
+            LittleFS.remove(CONFIG_JOURNAL_PATH);
+        }
+    }
     
     // Calculate simple checksum
     uint16_t calculateChecksum() {
@@ -85,6 +210,12 @@ private:
         // Timing defaults
         config.measurement_interval = 2000;
         
+        // Thermal camera: 4 Hz default (noise/speed compromise)
+        config.mlx_refresh = 0b011;
+
+        // Point-to-point USB by default; multidrop is a deployment choice
+        config.multidrop = false;
+        
         // Device label
         strncpy(config.device_label, "AMSKY01", sizeof(config.device_label));
         
@@ -92,12 +223,14 @@ private:
     }
     
 public:
-    ConfigManager() {
+    ConfigManager() : dirty_mask(0), fs_ok(false) {
         EEPROM.begin(EEPROM_SIZE);
     }
     
-    // Initialize configuration - load from EEPROM or use defaults
+    // Initialize configuration - load the EEPROM snapshot, then replay
+    // the change journal on top of it
     bool begin() {
+        fs_ok = LittleFS.begin();
         EEPROM.get(0, config);
         
         // Verify magic number and checksum
@@ -110,22 +243,73 @@ public:
             return false;
         }
         
-        Serial.println("# Config loaded from EEPROM");
+        // The snapshot is valid here, so config.multidrop is the real
+        // deployment choice - keep the boot print off a shared bus
+        if (!config.multidrop) {
+            Serial.println("# Config loaded from EEPROM");
+        }
+        journalReplay();
         return true;
     }
     
-    // Save configuration to EEPROM
+    // Full snapshot to EEPROM; also compacts away the journal, since
+    // the snapshot now carries everything
     bool save() {
         config.checksum = calculateChecksum();
         EEPROM.put(0, config);
         bool success = EEPROM.commit();
         if (success) {
+            journalClear();
+            dirty_mask = 0;
             Serial.println("# Config saved to EEPROM");
         } else {
             Serial.println("# Config save failed");
         }
         return success;
     }
+
+    // Persist only the fields changed since the last commit as journal
+    // records. This is the cheap path the setters feed - a nightly
+    // sqm_offset tweak appends 7 bytes instead of erasing the EEPROM
+    // sector. Compacts into a full snapshot when the journal grows past
+    // CONFIG_JOURNAL_MAX.
+    bool commitDirty() {
+        if (dirty_mask == 0) {
+            return true;
+        }
+        if (!fs_ok) {
+            // No filesystem - fall back to the full-block path
+            return save();
+        }
+
+        File f = LittleFS.open(CONFIG_JOURNAL_PATH, "a");
+        if (!f) {
+            return save();
+        }
+        for (uint8_t id = 1; id < CFG_FIELD_COUNT; id++) {
+            if (!(dirty_mask & ((uint16_t)1 << (id - 1)))) {
+                continue;
+            }
+            uint8_t *ptr;
+            uint8_t len;
+            if (!fieldPtr(id, &ptr, &len)) {
+                continue;
+            }
+            uint8_t cksum = recordChecksum(id, len, ptr);
+            f.write(&id, 1);
+            f.write(&len, 1);
+            f.write(ptr, len);
+            f.write(&cksum, 1);
+        }
+        size_t size = f.size();
+        f.close();
+        dirty_mask = 0;
+
+        if (size > CONFIG_JOURNAL_MAX) {
+            return save();
+        }
+        return true;
+    }
     
     // Reset to defaults
     void reset() {
@@ -148,25 +332,33 @@ public:
     float getAlertLightThreshold() { return config.alert_light_threshold; }
     bool isAlertLightAbove() { return config.alert_light_above; }
     uint16_t getMeasurementInterval() { return config.measurement_interval; }
+    uint8_t getMlxRefresh() { return config.mlx_refresh; }
+    bool isMultidrop() { return config.multidrop; }
     const char* getDeviceLabel() { return config.device_label; }
     
-    // Setters
-    void setSqmOffset(float value) { config.sqm_offset = value; }
-    void setSqmDarkCap(float value) { config.sqm_dark_cap = value; }
-    void setSqmOffsetBase(float value) { config.sqm_offset_base = value; }
-    void setSqmMagnitudeConst(float value) { config.sqm_magnitude_const = value; }
-    void setCloudThreshold(float value) { config.cloud_threshold = value; }
-    void setAlertEnabled(bool value) { config.alert_enabled = value; }
-    void setAlertOnCloud(bool value) { config.alert_on_cloud = value; }
-    void setAlertCloudTempThreshold(float value) { config.alert_cloud_temp_threshold = value; }
-    void setAlertCloudBelow(bool value) { config.alert_cloud_below = value; }
-    void setAlertOnLight(bool value) { config.alert_on_light = value; }
-    void setAlertLightThreshold(float value) { config.alert_light_threshold = value; }
-    void setAlertLightAbove(bool value) { config.alert_light_above = value; }
-    void setMeasurementInterval(uint16_t value) { config.measurement_interval = value; }
+    // Setters; unchanged values stay clean so commitDirty writes nothing
+    void setSqmOffset(float value) { if (config.sqm_offset != value) { config.sqm_offset = value; markDirty(CFG_SQM_OFFSET); } }
+    void setSqmDarkCap(float value) { if (config.sqm_dark_cap != value) { config.sqm_dark_cap = value; markDirty(CFG_SQM_DARK_CAP); } }
+    void setSqmOffsetBase(float value) { if (config.sqm_offset_base != value) { config.sqm_offset_base = value; markDirty(CFG_SQM_OFFSET_BASE); } }
+    void setSqmMagnitudeConst(float value) { if (config.sqm_magnitude_const != value) { config.sqm_magnitude_const = value; markDirty(CFG_SQM_MAGNITUDE_CONST); } }
+    void setCloudThreshold(float value) { if (config.cloud_threshold != value) { config.cloud_threshold = value; markDirty(CFG_CLOUD_THRESHOLD); } }
+    void setAlertEnabled(bool value) { if (config.alert_enabled != value) { config.alert_enabled = value; markDirty(CFG_ALERT_ENABLED); } }
+    void setAlertOnCloud(bool value) { if (config.alert_on_cloud != value) { config.alert_on_cloud = value; markDirty(CFG_ALERT_ON_CLOUD); } }
+    void setAlertCloudTempThreshold(float value) { if (config.alert_cloud_temp_threshold != value) { config.alert_cloud_temp_threshold = value; markDirty(CFG_ALERT_CLOUD_TEMP); } }
+    void setAlertCloudBelow(bool value) { if (config.alert_cloud_below != value) { config.alert_cloud_below = value; markDirty(CFG_ALERT_CLOUD_BELOW); } }
+    void setAlertOnLight(bool value) { if (config.alert_on_light != value) { config.alert_on_light = value; markDirty(CFG_ALERT_ON_LIGHT); } }
+    void setAlertLightThreshold(float value) { if (config.alert_light_threshold != value) { config.alert_light_threshold = value; markDirty(CFG_ALERT_LIGHT_THR); } }
+    void setAlertLightAbove(bool value) { if (config.alert_light_above != value) { config.alert_light_above = value; markDirty(CFG_ALERT_LIGHT_ABOVE); } }
+    void setMeasurementInterval(uint16_t value) { if (config.measurement_interval != value) { config.measurement_interval = value; markDirty(CFG_MEAS_INTERVAL); } }
+    void setMlxRefresh(uint8_t value) { if (config.mlx_refresh != value) { config.mlx_refresh = value; markDirty(CFG_MLX_REFRESH); } }
+    void setMultidrop(bool value) { if (config.multidrop != value) { config.multidrop = value; markDirty(CFG_MULTIDROP); } }
     void setDeviceLabel(const char* label) { 
+        if (strncmp(config.device_label, label, sizeof(config.device_label)) == 0) {
+            return;
+        }
         strncpy(config.device_label, label, sizeof(config.device_label) - 1);
         config.device_label[sizeof(config.device_label) - 1] = '\0';
+        markDirty(CFG_DEVICE_LABEL);
     }
     
     // Print current configuration
@@ -183,6 +375,8 @@ public:
         Serial.print("# Alert on Light: "); Serial.println(config.alert_on_light ? "YES" : "NO");
         Serial.print("# Alert Light Threshold: "); Serial.print(config.alert_light_threshold, 2); Serial.print(" lux "); Serial.println(config.alert_light_above ? "(above)" : "(below)");
         Serial.print("# Measurement Interval: "); Serial.print(config.measurement_interval); Serial.println(" ms");
+        Serial.print("# MLX Refresh Code: "); Serial.println(config.mlx_refresh);
+        Serial.print("# Multidrop Mode: "); Serial.println(config.multidrop ? "YES" : "NO");
         Serial.print("# Device Label: "); Serial.println(config.device_label);
         Serial.println("# ============================");
     }
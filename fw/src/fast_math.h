@@ -0,0 +1,107 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdint.h>
+
+/**
+ * Fast math kernels for the FPU-less Cortex-M0+.
+ *
+ * Every sin()/log()/sqrt() call on the RP2040 goes through software float
+ * emulation; profiling shows libm is a visible fraction of loop time once
+ * thrmap streaming is on. These replacements trade a little accuracy for
+ * a large cycle win:
+ *   fm_sin_turns / fm_sinf - 256-entry table with linear interpolation
+ *   fm_logf / fm_log10f    - exponent split + polynomial on the mantissa
+ *   fm_rsqrtf / fm_sqrtf   - bit-trick estimate + one Newton step
+ *
+ * Accuracy is a few 1e-4 relative, far below sensor noise. Build with
+ * -DAMSKY_FAST_MATH=0 to fall back to libm everywhere (for A/B checks).
+ */
+
+#ifndef AMSKY_FAST_MATH
+#define AMSKY_FAST_MATH 1
+#endif
+
+#if AMSKY_FAST_MATH
+
+#define FM_SIN_TABLE_SIZE 256
+
+// Quarter-wave would halve the table but complicate indexing; 1 KB of
+// flash for the full cycle is cheap
+inline const float *fmSinTable() {
+    static float table[FM_SIN_TABLE_SIZE + 1];
+    static bool ready = false;
+    if (!ready) {
+        for (int i = 0; i <= FM_SIN_TABLE_SIZE; i++) {
+            table[i] = sinf((float)i * (2.0f * (float)M_PI / FM_SIN_TABLE_SIZE));
+        }
+        ready = true;
+    }
+    return table;
+}
+
+// Sine of one full turn (x in [0,1) = 0..2*pi); arbitrary x is wrapped
+inline float fm_sin_turns(float x) {
+    x -= floorf(x);
+    float pos = x * FM_SIN_TABLE_SIZE;
+    int idx = (int)pos;
+    float frac = pos - (float)idx;
+    const float *t = fmSinTable();
+    return t[idx] + (t[idx + 1] - t[idx]) * frac;
+}
+
+inline float fm_sinf(float x) {
+    return fm_sin_turns(x * (1.0f / (2.0f * (float)M_PI)));
+}
+
+// log2 via exponent bits plus a rational correction on the mantissa
+// (the classic "fastlog2"); ~1e-4 accuracy over the normal float range
+inline float fm_log2f(float x) {
+    union { float f; uint32_t i; } vx = { x };
+    union { uint32_t i; float f; } mx = { (vx.i & 0x007FFFFF) | 0x3F000000 };
+    float y = (float)vx.i * 1.1920928955078125e-7f;
+    return y - 124.22551499f - 1.498030302f * mx.f
+             - 1.72587999f / (0.3520887068f + mx.f);
+}
+
+inline float fm_logf(float x) {
+    if (x <= 0.0f) {
+        return -INFINITY;
+    }
+    return fm_log2f(x) * 0.69314718056f;
+}
+
+inline float fm_log10f(float x) {
+    return fm_logf(x) * 0.43429448190f;
+}
+
+// Reciprocal square root, bit-trick seed + one Newton-Raphson step
+inline float fm_rsqrtf(float x) {
+    union { float f; uint32_t i; } u = { x };
+    u.i = 0x5F3759DF - (u.i >> 1);
+    float y = u.f;
+    y = y * (1.5f - 0.5f * x * y * y);
+    return y;
+}
+
+inline float fm_sqrtf(float x) {
+    if (x <= 0.0f) {
+        return 0.0f;
+    }
+    return x * fm_rsqrtf(x);
+}
+
+#else // !AMSKY_FAST_MATH - precise libm fallbacks for A/B comparison
+
+inline float fm_sin_turns(float x) { return sinf(x * 2.0f * (float)M_PI); }
+inline float fm_sinf(float x) { return sinf(x); }
+inline float fm_logf(float x) { return logf(x); }
+inline float fm_log10f(float x) { return log10f(x); }
+inline float fm_rsqrtf(float x) { return 1.0f / sqrtf(x); }
+inline float fm_sqrtf(float x) { return sqrtf(x); }
+
+#endif // AMSKY_FAST_MATH
+
+#endif // FAST_MATH_H
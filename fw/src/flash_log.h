@@ -0,0 +1,213 @@
+#ifndef FLASH_LOG_H
+#define FLASH_LOG_H
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+/**
+ * Flash-backed telemetry ring for host-disconnect backfill.
+ *
+ * Telemetry over USB is fire-and-forget: when the host NUC reboots or
+ * the link drops, those measurements used to be gone. This log keeps a
+ * rolling copy of the measurement sentences in the LittleFS area
+ * reserved in platformio.ini and serves it back with the "history <n>"
+ * command.
+ *
+ * Flash discipline: records accumulate in a 4 KB RAM block (one erase
+ * sector) and hit the filesystem only when the block fills or on the
+ * periodic flush, so steady-state logging costs one file append per
+ * ~40 s instead of one per sample. The on-flash ring is two files
+ * rotated at 64 KB each - LittleFS handles wear leveling underneath,
+ * the rotation just bounds total size and keeps deletes cheap.
+ *
+ * Stored line format: "<millis>,<tag>,<fields...>\n" (the leading '$'
+ * of the sentence is dropped). history replays the newest n lines as
+ * "$hist,<millis>,<tag>,<fields...>" in one burst.
+ */
+class FlashLog {
+private:
+    static const size_t BLOCK_SIZE = 4096;
+    static const size_t FILE_MAX = 65536;
+
+    char block[BLOCK_SIZE];
+    size_t fill;
+    bool fs_ok;
+    uint32_t dropped_lines;
+
+    const char *fileOld() const { return "/telem.0"; }
+    const char *fileCur() const { return "/telem.1"; }
+
+    // Rotate when the current file outgrows its half of the budget:
+    // the old file is dropped, current becomes old, a fresh one starts
+    void rotateIfNeeded() {
+        File f = LittleFS.open(fileCur(), "r");
+        if (!f) {
+            return;
+        }
+        size_t size = f.size();
+        f.close();
+        if (size < FILE_MAX) {
+            return;
+        }
+        LittleFS.remove(fileOld());
+        LittleFS.rename(fileCur(), fileOld());
+    }
+
+    static uint32_t countLines(File &f) {
+        uint32_t lines = 0;
+        uint8_t chunk[256];
+        while (true) {
+            size_t n = f.read(chunk, sizeof(chunk));
+            if (n == 0) {
+                break;
+            }
+            for (size_t i = 0; i < n; i++) {
+                if (chunk[i] == '\n') {
+                    lines++;
+                }
+            }
+        }
+        return lines;
+    }
+
+    // Print every line after skipping the first `skip`; prefix "$hist,"
+    static void printLines(File &f, uint32_t skip) {
+        char line[192];
+        size_t pos = 0;
+        uint8_t chunk[256];
+        while (true) {
+            size_t n = f.read(chunk, sizeof(chunk));
+            if (n == 0) {
+                break;
+            }
+            for (size_t i = 0; i < n; i++) {
+                char c = (char)chunk[i];
+                if (c == '\n') {
+                    if (skip > 0) {
+                        skip--;
+                    } else if (pos > 0) {
+                        line[pos] = '\0';
+                        Serial.print("$hist,");
+                        Serial.println(line);
+                    }
+                    pos = 0;
+                } else if (pos < sizeof(line) - 1) {
+                    line[pos++] = c;
+                }
+            }
+        }
+    }
+
+public:
+    FlashLog() : fill(0), fs_ok(false), dropped_lines(0) {}
+
+    void begin() {
+        fs_ok = LittleFS.begin();
+    }
+
+    // Append one sentence (as built by SentenceBuilder, with the leading
+    // '$' and trailing CRLF still attached) to the RAM block
+    void log(const char *sentence_buf, size_t sentence_len, uint32_t t_ms) {
+        if (!fs_ok) {
+            return;
+        }
+
+        // Strip "$" and CRLF; the timestamp prefix is added here
+        if (sentence_len > 0 && sentence_buf[0] == '$') {
+            sentence_buf++;
+            sentence_len--;
+        }
+        while (sentence_len > 0 && (sentence_buf[sentence_len - 1] == '\r' ||
+                                    sentence_buf[sentence_len - 1] == '\n')) {
+            sentence_len--;
+        }
+        // Drop the "*HH" checksum suffix; it was computed for the live
+        // sentence and would not match the $hist replay framing
+        if (sentence_len > 3 && sentence_buf[sentence_len - 3] == '*') {
+            sentence_len -= 3;
+        }
+
+        char prefix[16];
+        int plen = snprintf(prefix, sizeof(prefix), "%lu,", (unsigned long)t_ms);
+        size_t need = (size_t)plen + sentence_len + 1;
+
+        if (need > BLOCK_SIZE) {
+            dropped_lines++;
+            return;
+        }
+        if (fill + need > BLOCK_SIZE) {
+            flush();
+        }
+
+        memcpy(block + fill, prefix, plen);
+        fill += plen;
+        memcpy(block + fill, sentence_buf, sentence_len);
+        fill += sentence_len;
+        block[fill++] = '\n';
+    }
+
+    // Write the pending block out; called when the block fills and from
+    // a slow periodic task so a quiet station still bounds data loss
+    void flush() {
+        if (!fs_ok || fill == 0) {
+            return;
+        }
+        File f = LittleFS.open(fileCur(), "a");
+        if (f) {
+            f.write((const uint8_t *)block, fill);
+            f.close();
+            rotateIfNeeded();
+        } else {
+            dropped_lines++;
+        }
+        fill = 0;
+    }
+
+    // Stream the newest n logged lines in one burst. Writes directly to
+    // Serial (the caller flushes the TX ring first) - an explicit host
+    // request means the host is listening.
+    void history(uint32_t n) {
+        if (!fs_ok) {
+            Serial.println("# flash log unavailable");
+            return;
+        }
+        flush();
+
+        uint32_t in_old = 0;
+        uint32_t in_cur = 0;
+        File fo = LittleFS.open(fileOld(), "r");
+        if (fo) {
+            in_old = countLines(fo);
+        }
+        File fc = LittleFS.open(fileCur(), "r");
+        if (fc) {
+            in_cur = countLines(fc);
+        }
+        uint32_t total = in_old + in_cur;
+
+        uint32_t skip = (total > n) ? (total - n) : 0;
+        if (fo) {
+            if (skip < in_old) {
+                fo.seek(0);
+                printLines(fo, skip);
+                skip = 0;
+            } else {
+                skip -= in_old;
+            }
+            fo.close();
+        }
+        if (fc) {
+            fc.seek(0);
+            printLines(fc, skip);
+            fc.close();
+        }
+        Serial.print("# history end, lines=");
+        Serial.println(total > n ? n : total);
+    }
+
+    uint32_t droppedLines() const { return dropped_lines; }
+};
+
+extern FlashLog flashLog;
+
+#endif // FLASH_LOG_H
@@ -0,0 +1,29 @@
+#ifndef I2C_LOCK_H
+#define I2C_LOCK_H
+
+#include <pico/mutex.h>
+
+/**
+ * Shared lock for the sensor I2C bus (Wire1).
+ *
+ * The MLX90641 worker on core1 and the SHT4x/TSL2591 reads on core0 use the
+ * same physical bus, so every transaction has to be bracketed by this mutex.
+ * The MLX90641 I2C driver takes it internally; core0 code wraps the Adafruit
+ * library calls explicitly.
+ */
+
+extern mutex_t amskyI2cMutex;
+
+inline void amskyI2cLockInit() {
+    mutex_init(&amskyI2cMutex);
+}
+
+inline void amskyI2cLock() {
+    mutex_enter_blocking(&amskyI2cMutex);
+}
+
+inline void amskyI2cUnlock() {
+    mutex_exit(&amskyI2cMutex);
+}
+
+#endif // I2C_LOCK_H
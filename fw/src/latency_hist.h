@@ -0,0 +1,67 @@
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <Arduino.h>
+
+/**
+ * Compact log2 latency histogram.
+ *
+ * Bucket i counts samples in [2^i, 2^(i+1)) microseconds, so 24 buckets
+ * cover 1 us .. ~16 s with 96 bytes of counters. Used for loop-pass
+ * jitter and the measurement-to-trigger-output latency of the alert
+ * path; dumped with the hist_show command and cleared with hist_reset.
+ * Recording is a clz + one increment, cheap enough for the hot path.
+ */
+struct Log2Hist {
+    static const uint8_t BUCKETS = 24;
+    uint32_t counts[BUCKETS];
+    uint32_t samples;
+    uint32_t max_us;
+
+    Log2Hist() { reset(); }
+
+    void reset() {
+        memset(counts, 0, sizeof(counts));
+        samples = 0;
+        max_us = 0;
+    }
+
+    void record(uint32_t us) {
+        uint8_t bucket = 0;
+        if (us > 0) {
+            bucket = (uint8_t)(31 - __builtin_clz(us));
+            if (bucket >= BUCKETS) {
+                bucket = BUCKETS - 1;
+            }
+        }
+        counts[bucket]++;
+        samples++;
+        if (us > max_us) {
+            max_us = us;
+        }
+    }
+
+    // Human-readable dump; empty buckets are skipped
+    void print(const char *name) const {
+        Serial.print("# ");
+        Serial.print(name);
+        Serial.print(": n=");
+        Serial.print(samples);
+        Serial.print(" max=");
+        Serial.print(max_us);
+        Serial.println(" us");
+        for (uint8_t i = 0; i < BUCKETS; i++) {
+            if (counts[i] == 0) {
+                continue;
+            }
+            Serial.print("#   ");
+            Serial.print((uint32_t)1 << i);
+            Serial.print("-");
+            Serial.print(((uint32_t)1 << (i + 1)) - 1);
+            Serial.print(" us: ");
+            Serial.println(counts[i]);
+        }
+    }
+};
+
+#endif // LATENCY_HIST_H
@@ -0,0 +1,97 @@
+#ifndef LED_ENGINE_H
+#define LED_ENGINE_H
+
+#include <Arduino.h>
+#include <pico/time.h>
+#include <hardware/pwm.h>
+
+#include "fast_math.h"
+
+/**
+ * LED effects on a repeating hardware timer.
+ *
+ * The status LED breathing and the trigger idle blink used to run as
+ * scheduler tasks, costing a sine evaluation and an analogWrite on
+ * core0's time. Here the brightness curve is precomputed once into a
+ * 64-entry table and a 31 ms repeating timer just steps an index and
+ * writes the PWM compare register - the measurement loop does no LED
+ * work at all.
+ *
+ * The trigger blink is an idle indication only: when alerts are
+ * enabled the pin belongs to the alert logic (see updateTriggerOutput
+ * in main.cpp) and the engine leaves it alone via setBlinkEnabled.
+ */
+class LedEngine {
+private:
+    static const uint8_t TABLE_SIZE = 64;
+    static const uint32_t TICK_MS = 31;          // ~2 s breathing period
+    static const uint8_t BLINK_TICKS = 32;       // ~1 s trigger toggle
+
+    uint8_t table[TABLE_SIZE];
+    uint8_t breath_pin;
+    uint8_t trigger_pin;
+    repeating_timer timer;
+
+    volatile uint8_t phase;
+    volatile uint8_t blink_counter;
+    volatile bool blink_state;
+    volatile bool blink_enabled;
+
+    // Timer callback runs in interrupt context: one table lookup, one
+    // PWM compare write, occasionally one GPIO toggle
+    void tick() {
+        phase = (phase + 1) % TABLE_SIZE;
+        pwm_set_gpio_level(breath_pin, table[phase]);
+
+        if (blink_enabled) {
+            if (++blink_counter >= BLINK_TICKS) {
+                blink_counter = 0;
+                blink_state = !blink_state;
+                gpio_put(trigger_pin, blink_state);
+            }
+        } else {
+            blink_counter = 0;
+        }
+    }
+
+    static bool timerCallback(repeating_timer *t) {
+        ((LedEngine *)t->user_data)->tick();
+        return true;  // keep repeating
+    }
+
+public:
+    LedEngine()
+        : breath_pin(0), trigger_pin(0), phase(0), blink_counter(0),
+          blink_state(false), blink_enabled(true) {}
+
+    void begin(uint8_t breathPin, uint8_t triggerPin) {
+        breath_pin = breathPin;
+        trigger_pin = triggerPin;
+
+        // Same curve as the old task: sine mapped to duty 0..64 of 255
+        // (reduced brightness); computed once, never in the timer
+        for (uint8_t i = 0; i < TABLE_SIZE; i++) {
+            float s = fm_sin_turns((float)i / TABLE_SIZE);
+            table[i] = (uint8_t)(32.0f + 32.0f * s);
+        }
+
+        // Drive the breathing pin from its PWM slice directly so the
+        // timer callback only touches the compare register
+        gpio_set_function(breath_pin, GPIO_FUNC_PWM);
+        uint slice = pwm_gpio_to_slice_num(breath_pin);
+        pwm_set_wrap(slice, 255);
+        pwm_set_gpio_level(breath_pin, 0);
+        pwm_set_enabled(slice, true);
+
+        add_repeating_timer_ms(-(int32_t)TICK_MS, timerCallback, this, &timer);
+    }
+
+    // Alert logic owns the trigger pin while blinking is disabled
+    void setBlinkEnabled(bool enabled) {
+        blink_enabled = enabled;
+    }
+};
+
+extern LedEngine ledEngine;
+
+#endif // LED_ENGINE_H
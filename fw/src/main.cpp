@@ -5,8 +5,22 @@
 #include "MLX90641.h"
 #include "version.h"
 #include "sqm_utils.h"
+#include "sqm_filter.h"
 #include "amsky01_utils.h"
 #include "config.h"
+#include "i2c_lock.h"
+#include "telemetry.h"
+#include "fast_math.h"
+#include "scheduler.h"
+#include "profiler.h"
+#include "latency_hist.h"
+#include "command.h"
+#include "led_engine.h"
+#include "flash_log.h"
+#include "ram_history.h"
+
+// Shared I2C bus lock (Wire1 is used from both cores, see i2c_lock.h)
+mutex_t amskyI2cMutex;
 
 // RP2040 bootloader reset function
 extern "C" {
@@ -23,6 +37,19 @@ extern "C" {
 #define SDA_PIN 18   // I2C1 SDA
 #define SCL_PIN 19   // I2C1 SCL
 
+// Optional: run the MLX90641 on its own controller (I2C0) so the large
+// frame reads do not serialize behind SHT4x/TSL2591 transactions on
+// Wire1. Requires the camera to be wired to I2C0-capable pins; enable
+// with -DMLX_ON_I2C0 in platformio.ini on boards routed that way.
+#ifdef MLX_ON_I2C0
+#ifndef MLX_SDA_PIN
+#define MLX_SDA_PIN 20  // I2C0 SDA
+#endif
+#ifndef MLX_SCL_PIN
+#define MLX_SCL_PIN 21  // I2C0 SCL
+#endif
+#endif
+
 // Initialize SHT45 sensor
 Adafruit_SHT4x sht4 = Adafruit_SHT4x();
 
@@ -35,24 +62,84 @@ MLX90641 mlxSensor;
 // Initialize configuration manager
 ConfigManager configManager;
 
-// Variables for LEDs
-bool trigger_led_state = false;
-unsigned long last_trigger_blink = 0;
-const unsigned long TRIGGER_BLINK_INTERVAL = 1000; // 1000ms - slower blink
+// Shared builder for all outgoing telemetry sentences
+SentenceBuilder sentence;
+
+// TX ring in front of the serial port (see telemetry.h)
+TxRing txRing;
+
+// Flash-backed telemetry ring for host-disconnect backfill (see flash_log.h)
+FlashLog flashLog;
+
+// RAM history ring with on-device aggregates (see ram_history.h)
+RamHistory ramHistory;
+
+// Cooperative scheduler; every subsystem runs as its own task with an
+// independent period (see scheduler.h)
+Scheduler scheduler;
+SchedTask *hygro_task = nullptr;
+SchedTask *light_task = nullptr;
+SchedTask *bringup_task = nullptr;
+#ifdef AMSKY_BENCH_AUTORUN
+SchedTask *bench_task = nullptr;
+#endif
+
+// Per-stage cycle profiling (see profiler.h)
+Profiler profiler;
+ProfStage *prof_hygro = nullptr;
+ProfStage *prof_light = nullptr;
+ProfStage *prof_sqm = nullptr;
+ProfStage *prof_thermal = nullptr;
+ProfStage *prof_thrmap_fmt = nullptr;
+ProfStage *prof_mlx_poll = nullptr;
+ProfStage *prof_tx_drain = nullptr;
+
+// LED effects run on a hardware timer (see led_engine.h)
+LedEngine ledEngine;
 
-// CPU LED PWM breathing effect
-const unsigned long CPU_BREATHING_PERIOD = 2000; // 2 seconds for full cycle
-const float MY_PI = 3.14159265359;
+// Alert state driving the trigger output when alerts are enabled
+// (the idle blink on TRIGGER_OUT_LED is suppressed in that mode)
+bool alert_cloud_active = false;
+bool alert_light_active = false;
+
+// Latency instrumentation: loop-pass duration and the latency from
+// thermal frame completion to the trigger output update (see
+// latency_hist.h); dumped with hist_show, cleared with hist_reset
+Log2Hist loopJitterHist;
+Log2Hist triggerLatencyHist;
 
 // Variables for sensors
 bool sht4_available = false;
 bool tsl_available = false;
-unsigned long last_measurement = 0;
-const unsigned long MEASUREMENT_INTERVAL = 2000; // 2 seconds
+
+// Incremental sensor bring-up: one sensor per state so the loop (serial
+// commands, LEDs, TX drain) runs from the first millisecond and a slow
+// or absent sensor cannot stall the others
+enum BringupState {
+  BRINGUP_SHT4,
+  BRINGUP_TSL,
+  BRINGUP_MLX,
+  BRINGUP_DONE
+};
+BringupState bringup_state = BRINGUP_SHT4;
 
 // Režim posílání celé IR mapy po UARTu
 bool thrmap_streaming = false;
 
+// Binární protokol pro thrmap (viz telemetry.h); ASCII zůstává default
+bool proto_binary = false;
+
+// Delta kódování thrmap streamu (jen v binárním režimu)
+bool thrmap_delta = false;
+ThrmapDeltaEncoder thrmapDelta;
+
+// Multi-drop bus mode (RS-485 chain): sentences carry the unit address,
+// commands must be addressed, and the TX ring drains only when polled
+bool multidrop_active = false;
+
+// Klouzavý medián + MAD detekce odlehlých SQM hodnot (viz sqm_filter.h)
+SqmFilter sqmFilter;
+
 // Enter UF2 bootloader mode
 static void enterUf2Bootloader() {
   Serial.println("# Entering UF2 bootloader mode...");
@@ -61,330 +148,878 @@ static void enterUf2Bootloader() {
   reset_usb_boot(0, 0);  // Reset to UF2 bootloader in ROM
 }
 
-static void processSerialCommand(const char *cmd)
-{
-  if (strcmp(cmd, "thrmap_on") == 0)
-  {
-    thrmap_streaming = true;
-    Serial.println("# thrmap streaming ON");
-  }
-  else if (strcmp(cmd, "thrmap_off") == 0)
-  {
-    thrmap_streaming = false;
-    Serial.println("# thrmap streaming OFF");
+// ---- Serial commands ------------------------------------------------------
+// Handlers + hashed dispatch table (see command.h). Dispatch is one
+// FNV-1a hash and a table scan; the old strcmp chain is gone.
+
+static void cmdThrmapOn(CmdArgs &) {
+  thrmap_streaming = true;
+  Serial.println("# thrmap streaming ON");
+}
+
+static void cmdThrmapOff(CmdArgs &) {
+  thrmap_streaming = false;
+  Serial.println("# thrmap streaming OFF");
+}
+
+static void cmdProtoBin(CmdArgs &) {
+  proto_binary = true;
+  Serial.println("# binary protocol ON");
+}
+
+static void cmdProtoAscii(CmdArgs &) {
+  proto_binary = false;
+  Serial.println("# binary protocol OFF");
+}
+
+static void cmdThrmapDeltaOn(CmdArgs &) {
+  thrmap_delta = true;
+  thrmapDelta.reset();
+  Serial.println("# thrmap delta encoding ON");
+}
+
+static void cmdThrmapDeltaOff(CmdArgs &) {
+  thrmap_delta = false;
+  Serial.println("# thrmap delta encoding OFF");
+}
+
+static void cmdStatsShow(CmdArgs &) {
+  profiler.print();
+}
+
+static void cmdHistShow(CmdArgs &) {
+  loopJitterHist.print("loop_pass");
+  triggerLatencyHist.print("meas_to_trigger");
+}
+
+static void cmdHistReset(CmdArgs &) {
+  loopJitterHist.reset();
+  triggerLatencyHist.reset();
+  Serial.println("# histograms reset");
+}
+
+// "raw <n>" replays the newest n RAM history rows as $rhist
+static void cmdRaw(CmdArgs &args) {
+  uint16_t n = 60;
+  char *arg = args.next();
+  if (arg != nullptr && atol(arg) > 0) {
+    n = (uint16_t)atol(arg);
   }
-  else if (strcmp(cmd, "config_show") == 0)
-  {
-    configManager.printConfig();
+  ramHistory.emitRaw(sentence, n);
+}
+
+// "agg <minutes>" answers with one $agg aggregate sentence
+static void cmdAgg(CmdArgs &args) {
+  uint32_t minutes = 30;
+  char *arg = args.next();
+  if (arg != nullptr && atol(arg) > 0) {
+    minutes = (uint32_t)atol(arg);
   }
-  else if (strcmp(cmd, "config_save") == 0)
-  {
-    configManager.save();
+  ramHistory.emitAggregates(sentence, minutes * 60, millis());
+}
+
+// "history <n>" streams the newest n flash-logged sentences in one burst
+static void cmdHistory(CmdArgs &args) {
+  uint32_t n = 100;
+  char *arg = args.next();
+  if (arg != nullptr && atol(arg) > 0) {
+    n = (uint32_t)atol(arg);
   }
-  else if (strcmp(cmd, "config_reset") == 0)
+  flashLog.history(n);
+}
+
+static void cmdConfigShow(CmdArgs &) {
+  configManager.printConfig();
+}
+
+static void cmdConfigSave(CmdArgs &) {
+  configManager.save();
+}
+
+static void cmdConfigReset(CmdArgs &) {
+  configManager.reset();
+}
+
+static void cmdBootloader(CmdArgs &) {
+  enterUf2Bootloader();
+}
+
+// Multi-drop poll: the host grants this unit the bus. The queued
+// telemetry was already flushed before dispatch (see command.h); the
+// $pollend marker closes the burst so the host knows it can address
+// the next unit in the chain. Harmless on point-to-point links.
+static void cmdPoll(CmdArgs &) {
+  sentence.begin("pollend");
+  sentence.addUint(txRing.droppedBytes());
+  sentence.send();
+  txRing.flush();
+}
+
+// ---- Microbenchmarks ------------------------------------------------------
+// "bench" runs the key kernels over fixed synthetic inputs (and the last
+// real MLX frame) and reports cycles/op, so a firmware change can be
+// gated on measured numbers instead of flashing and guessing. Results go
+// out as $bench,<seq>,<name>,<iters>,<cycles/op>,<us/op> sentences.
+
+// Sink defeats dead-code elimination of the benchmarked kernels
+static volatile float bench_sink;
+
+static void benchReport(const char *name, uint32_t iters, uint32_t cycles_op) {
+  sentence.begin("bench");
+  sentence.addStr(name);
+  sentence.addUint(iters);
+  sentence.addUint(cycles_op);
+  sentence.addFloat((float)cycles_op / (float)(F_CPU / 1000000UL), 2);
+  sentence.send();
+}
+
+static void cmdBench(CmdArgs &) {
+  Serial.println("# bench: running (loop blocked for the duration)");
+
+  // SQM conversion over varying synthetic raw inputs
   {
-    configManager.reset();
+    const uint32_t iters = 2000;
+    uint32_t t0 = rp2040.getCycleCount();
+    for (uint32_t i = 0; i < iters; i++) {
+      SQMResult r = calculate_sqm_from_raw(
+          (uint16_t)(120 + (i & 31)), 1500, 25.0f, 200.0f, 1,
+          configManager.getSqmOffsetBase(),
+          configManager.getSqmMagnitudeConst(), 0.0f);
+      bench_sink = r.mpsas;
+    }
+    benchReport("sqm_calc", iters, (rp2040.getCycleCount() - t0) / iters);
   }
-  else if (strcmp(cmd, "bootloader") == 0)
+
+  // Sentence formatting: a representative $light-sized line, built but
+  // not sent (begin() of the next iteration discards it)
   {
-    enterUf2Bootloader();
+    const uint32_t iters = 500;
+    uint32_t t0 = rp2040.getCycleCount();
+    for (uint32_t i = 0; i < iters; i++) {
+      sentence.begin("benchfmt");
+      sentence.addUint(123456 + i);
+      sentence.addUint(1500);
+      sentence.addUint(120);
+      sentence.addFloat(19.85f, 2);
+      sentence.addFloat(19.84f, 2);
+      sentence.addUint(0);
+    }
+    uint32_t cyc = (rp2040.getCycleCount() - t0) / iters;
+    benchReport("sentence_fmt", iters, cyc);
   }
-  else if (strncmp(cmd, "set ", 4) == 0)
+
+  // Thermal pipeline over the last real frame and calibration
   {
-    // Parse "set <param> <value>" commands
-    const char* params = cmd + 4;
-    char param[32];
-    char value[32];
-    
-    if (sscanf(params, "%s %s", param, value) == 2)
-    {
-      if (strcmp(param, "sqm_offset") == 0) {
-        configManager.setSqmOffset(atof(value));
-        Serial.print("# Set sqm_offset = "); Serial.println(value);
-      }
-      else if (strcmp(param, "alert_enabled") == 0) {
-        configManager.setAlertEnabled(atoi(value));
-        Serial.print("# Set alert_enabled = "); Serial.println(value);
+    uint32_t ref, fast, stats;
+    if (mlxSensor.benchCompute(20, ref, fast, stats)) {
+      benchReport("mlx_calcto_ref", 20, ref);
+      if (fast > 0) {
+        benchReport("mlx_calcto_fast", 20, fast);
       }
-      else if (strcmp(param, "alert_cloud_temp") == 0) {
-        configManager.setAlertCloudTempThreshold(atof(value));
-        Serial.print("# Set alert_cloud_temp = "); Serial.println(value);
-      }
-      else if (strcmp(param, "alert_cloud_below") == 0) {
-        configManager.setAlertCloudBelow(atoi(value));
-        Serial.print("# Set alert_cloud_below = "); Serial.println(value);
-      }
-      else if (strcmp(param, "alert_light_lux") == 0) {
-        configManager.setAlertLightThreshold(atof(value));
-        Serial.print("# Set alert_light_lux = "); Serial.println(value);
-      }
-      else if (strcmp(param, "alert_light_above") == 0) {
-        configManager.setAlertLightAbove(atoi(value));
-        Serial.print("# Set alert_light_above = "); Serial.println(value);
-      }
-      else if (strcmp(param, "device_label") == 0) {
-        configManager.setDeviceLabel(value);
-        Serial.print("# Set device_label = "); Serial.println(value);
-      }
-      else {
-        Serial.print("# Unknown parameter: "); Serial.println(param);
-      }
-    }
-    else {
-      Serial.println("# Invalid set command format. Use: set <param> <value>");
+      benchReport("mlx_stats", 20, stats);
+    } else {
+      Serial.println("# bench: mlx skipped (no frame yet)");
     }
   }
-  else
+
+  // Full EEPROM snapshot - one shot, flash erase dominates
   {
-    Serial.print("# Unknown command: "); Serial.println(cmd);
+    uint32_t t0 = rp2040.getCycleCount();
+    configManager.save();
+    benchReport("eeprom_save", 1, rp2040.getCycleCount() - t0);
   }
+
+  txRing.flush();
+  Serial.println("# bench: done");
 }
 
-static void handleSerialCommands()
-{
-  static char buf[64];
-  static uint8_t pos = 0;
+#ifdef AMSKY_BENCH_AUTORUN
+// Dedicated pico_bench env: run the suite once after bring-up and the
+// first thermal frames have settled, then go back to normal operation
+static void taskBenchAutorun() {
+  if (bench_task != nullptr) {
+    bench_task->enabled = false;
+  }
+  CmdArgs none(nullptr);
+  cmdBench(none);
+}
+#endif
 
-  while (Serial.available() > 0)
-  {
-    char c = Serial.read();
-    if (c == '\n' || c == '\r')
-    {
-      if (pos > 0)
-      {
-        buf[pos] = '\0';
-        processSerialCommand(buf);
-        pos = 0;
+// "set <param> <value>" - the parameters get their own hashed table.
+// An apply function returns true for the standard confirmation print,
+// false when it already reported (validation errors).
+struct SetParam {
+  uint32_t hash;
+  const char *name;
+  bool (*apply)(const char *value);
+};
+
+#define SET_PARAM(name, fn) { cmdHash(name), name, fn }
+
+static bool setSqmOffset(const char *v) {
+  configManager.setSqmOffset(atof(v));
+  return true;
+}
+
+static bool setAlertEnabled(const char *v) {
+  bool enabled = atoi(v) != 0;
+  configManager.setAlertEnabled(enabled);
+  // Give the idle blink back to the LED engine when alerts are off
+  ledEngine.setBlinkEnabled(!enabled);
+  return true;
+}
+
+static bool setAlertCloudTemp(const char *v) {
+  configManager.setAlertCloudTempThreshold(atof(v));
+  return true;
+}
+
+static bool setAlertCloudBelow(const char *v) {
+  configManager.setAlertCloudBelow(atoi(v));
+  return true;
+}
+
+static bool setAlertLightLux(const char *v) {
+  configManager.setAlertLightThreshold(atof(v));
+  return true;
+}
+
+static bool setAlertLightAbove(const char *v) {
+  configManager.setAlertLightAbove(atoi(v));
+  return true;
+}
+
+static bool setThrmapKeyframe(const char *v) {
+  thrmapDelta.keyframe_interval = (uint16_t)atoi(v);
+  return true;
+}
+
+static bool setThrmapDeltaThr(const char *v) {
+  thrmapDelta.threshold_centideg = (uint16_t)atoi(v);
+  return true;
+}
+
+static bool setMeasInterval(const char *v) {
+  uint16_t interval = (uint16_t)atoi(v);
+  if (interval < 100) {
+    Serial.println("# meas_interval must be >= 100 ms");
+    return false;
+  }
+  configManager.setMeasurementInterval(interval);
+  if (hygro_task != nullptr) hygro_task->period_ms = interval;
+  if (light_task != nullptr) light_task->period_ms = interval;
+  return true;
+}
+
+static bool setDeviceLabel(const char *v) {
+  configManager.setDeviceLabel(v);
+  return true;
+}
+
+extern CommandProcessor commandProc;
+
+// Multi-drop mode applies immediately: on 1 the device stops talking
+// until polled, which is exactly what plugging it into a shared bus
+// needs (and is undone point-to-point with "set multidrop 0")
+static bool setMultidrop(const char *v) {
+  bool on = atoi(v) != 0;
+  configManager.setMultidrop(on);
+  uint8_t addr = on ? getBusAddress() : 0;
+  sentence.setBusAddress(addr);
+  commandProc.setBusAddress(addr);
+  multidrop_active = on;
+  return true;
+}
+
+static bool setMlxRefresh(const char *v) {
+  uint8_t code = (uint8_t)atoi(v);
+  if (code > 7 || !mlxSensor.setRefreshRate(code)) {
+    Serial.println("# mlx_refresh must be 0..7 (datasheet code, 3 = 4 Hz, 5 = 16 Hz)");
+    return false;
+  }
+  configManager.setMlxRefresh(code);
+  return true;
+}
+
+static const SetParam setParams[] = {
+  SET_PARAM("sqm_offset", setSqmOffset),
+  SET_PARAM("alert_enabled", setAlertEnabled),
+  SET_PARAM("alert_cloud_temp", setAlertCloudTemp),
+  SET_PARAM("alert_cloud_below", setAlertCloudBelow),
+  SET_PARAM("alert_light_lux", setAlertLightLux),
+  SET_PARAM("alert_light_above", setAlertLightAbove),
+  SET_PARAM("thrmap_keyframe", setThrmapKeyframe),
+  SET_PARAM("thrmap_delta_thr", setThrmapDeltaThr),
+  SET_PARAM("meas_interval", setMeasInterval),
+  SET_PARAM("device_label", setDeviceLabel),
+  SET_PARAM("mlx_refresh", setMlxRefresh),
+  SET_PARAM("multidrop", setMultidrop),
+};
+
+static void cmdSet(CmdArgs &args) {
+  char *param = args.next();
+  char *value = args.next();
+  if (param == nullptr || value == nullptr) {
+    Serial.println("# Invalid set command format. Use: set <param> <value>");
+    return;
+  }
+
+  uint32_t h = cmdHash(param);
+  for (uint8_t i = 0; i < sizeof(setParams) / sizeof(setParams[0]); i++) {
+    if (setParams[i].hash == h && strcmp(setParams[i].name, param) == 0) {
+      if (setParams[i].apply(value)) {
+        // Journal only the fields that actually changed; a no-op set
+        // writes nothing to flash
+        configManager.commitDirty();
+        Serial.print("# Set "); Serial.print(param);
+        Serial.print(" = "); Serial.println(value);
       }
-    }
-    else if (pos < sizeof(buf) - 1)
-    {
-      buf[pos++] = c;
+      return;
     }
   }
+  Serial.print("# Unknown parameter: "); Serial.println(param);
 }
 
+static const CmdEntry commandTable[] = {
+  CMD_ENTRY("thrmap_on", cmdThrmapOn),
+  CMD_ENTRY("thrmap_off", cmdThrmapOff),
+  CMD_ENTRY("proto_bin", cmdProtoBin),
+  CMD_ENTRY("proto_ascii", cmdProtoAscii),
+  CMD_ENTRY("thrmap_delta_on", cmdThrmapDeltaOn),
+  CMD_ENTRY("thrmap_delta_off", cmdThrmapDeltaOff),
+  CMD_ENTRY("stats_show", cmdStatsShow),
+  CMD_ENTRY("hist_show", cmdHistShow),
+  CMD_ENTRY("hist_reset", cmdHistReset),
+  CMD_ENTRY("raw", cmdRaw),
+  CMD_ENTRY("agg", cmdAgg),
+  CMD_ENTRY("history", cmdHistory),
+  CMD_ENTRY("config_show", cmdConfigShow),
+  CMD_ENTRY("config_save", cmdConfigSave),
+  CMD_ENTRY("config_reset", cmdConfigReset),
+  CMD_ENTRY("bootloader", cmdBootloader),
+  CMD_ENTRY("poll", cmdPoll),
+  CMD_ENTRY("bench", cmdBench),
+  CMD_ENTRY("set", cmdSet),
+};
+
+CommandProcessor commandProc(commandTable, sizeof(commandTable) / sizeof(commandTable[0]));
+
+// Scheduler tasks (defined below loop() section)
+static void taskTxDrain();
+static void taskSerialCommands();
+static void taskMlxPoll();
+static void taskHygro();
+static void taskLight();
+static void taskThermal();
+static void taskTxStats();
+static void taskProfStats();
+static void taskBringup();
+static void taskLogFlush();
+static void taskHistSample();
+
 void setup() {
-  // Initialize serial communication
+  // Initialize serial communication. Wait briefly for a host to open the
+  // port so the banner is not lost, but give up fast when headless -
+  // after a power blip the station must be measuring again in well under
+  // half a second, not sitting in a fixed delay.
   Serial.begin(115200);
-  delay(2000);
+  unsigned long serial_wait_start = millis();
+  while (!Serial && (millis() - serial_wait_start) < 250) {
+    delay(10);
+  }
   
-  // Initialize GPIO pins
-  pinMode(CPU_STATUS_LED, OUTPUT);
+  // Initialize GPIO pins; CPU_STATUS_LED is taken over by the LED
+  // engine's PWM slice in ledEngine.begin()
   pinMode(TRIGGER_OUT_LED, OUTPUT);
-  
-  // LEDs off at start
-  digitalWrite(CPU_STATUS_LED, LOW);
   digitalWrite(TRIGGER_OUT_LED, LOW);
-  
+
+  // LED effects run from a repeating hardware timer from here on
+  ledEngine.begin(CPU_STATUS_LED, TRIGGER_OUT_LED);
+
+  // Configuration first: multidrop mode decides how everything after
+  // this point may talk on the (possibly shared) serial bus
+  configManager.begin();
+  multidrop_active = configManager.isMultidrop();
+  if (multidrop_active) {
+    uint8_t addr = getBusAddress();
+    sentence.setBusAddress(addr);
+    commandProc.setBusAddress(addr);
+  }
+
   // Get device serial number
   String serial_number = getDeviceSerialNumber();
-  
-  // Print device information
-  Serial.print("# ");
-  Serial.println(DEVICE_NAME);
-  Serial.print("# Serial Number: ");
-  Serial.println(serial_number);
-  Serial.print("# FW Version: ");
-  Serial.println(FW_VERSION);
-  Serial.print("# Git Hash: ");
-  Serial.println(GIT_HASH);
-  Serial.print("# Git Branch: ");
-  Serial.println(GIT_BRANCH);
-  Serial.println("#");
-  
-  // Send structured HELLO message with device identification
-  // Format: $HELLO,<device_name>,<serial_number>,<fw_version>,<git_hash>,<git_branch>
-  Serial.print("$HELLO,");
-  Serial.print(DEVICE_NAME);
-  Serial.print(",");
-  Serial.print(serial_number);
-  Serial.print(",");
-  Serial.print(FW_VERSION);
-  Serial.print(",");
-  Serial.print(GIT_HASH);
-  Serial.print(",");
-  Serial.print(GIT_BRANCH);
-  Serial.println();
-  
+  char bus_addr_hex[3];
+  snprintf(bus_addr_hex, sizeof(bus_addr_hex), "%02X", getBusAddress());
+
+  // Print device information - suppressed on a shared bus, where
+  // unsolicited output would collide with other units
+  if (!multidrop_active) {
+    Serial.print("# ");
+    Serial.println(DEVICE_NAME);
+    Serial.print("# Serial Number: ");
+    Serial.println(serial_number);
+    Serial.print("# Bus Address: ");
+    Serial.println(bus_addr_hex);
+    Serial.print("# FW Version: ");
+    Serial.println(FW_VERSION);
+    Serial.print("# Git Hash: ");
+    Serial.println(GIT_HASH);
+    Serial.print("# Git Branch: ");
+    Serial.println(GIT_BRANCH);
+    Serial.println("#");
+  }
+
+  // Send structured HELLO message with device identification. In
+  // multidrop mode this only queues into the TX ring and goes out with
+  // the first poll, so a freshly booted unit stays off the bus.
+  // Format: $HELLO,<device_name>,<serial_number>,<fw_version>,<git_hash>,<git_branch>,<bus_addr>
+  sentence.begin("HELLO");
+  sentence.addStr(DEVICE_NAME);
+  sentence.addStr(serial_number.c_str());
+  sentence.addStr(FW_VERSION);
+  sentence.addStr(GIT_HASH);
+  sentence.addStr(GIT_BRANCH);
+  sentence.addStr(bus_addr_hex);
+  sentence.send();
+
+  // Initialize the shared I2C bus lock before anything touches Wire1
+  amskyI2cLockInit();
+
   // Initialize I2C1 with specific pins (GPIO 18=SDA, GPIO 19=SCL)
   Wire1.setSDA(SDA_PIN);
   Wire1.setSCL(SCL_PIN);
   Wire1.begin();
-  delay(100);
-  
-  // Initialize SHT45 sensor on I2C1
-  if (sht4.begin(&Wire1)) {
-    sht4_available = true;
-    
-    // Set precision and heater
-    sht4.setPrecision(SHT4X_HIGH_PRECISION);
-    sht4.setHeater(SHT4X_NO_HEATER);
-    Serial.println("# SHT4x sensor initialized successfully");
-  } else {
-    sht4_available = false;
-    Serial.println("# SHT4x sensor initialization failed");
+
+#ifdef MLX_ON_I2C0
+  // Dedicated controller for the thermal camera: frame reads run
+  // concurrently with the light/hygro traffic on Wire1
+  Wire.setSDA(MLX_SDA_PIN);
+  Wire.setSCL(MLX_SCL_PIN);
+  Wire.begin();
+#endif
+
+  // Sensors come up incrementally in taskBringup - setup() itself does
+  // no sensor I2C, so the first loop() pass runs almost immediately
+
+  // Configuration was loaded at the top of setup(); the dump stays off
+  // a shared bus
+  if (!multidrop_active) {
+    configManager.printConfig();
   }
-  
-  // Initialize AMS TSL2591 light sensor on I2C1
-  if (amsSensor.begin(&Wire1)) {
-    tsl_available = true;
-  } else {
-    tsl_available = false;
+
+  // With alerts configured on, the trigger pin is an output signal,
+  // not an idle blinker
+  ledEngine.setBlinkEnabled(!configManager.isAlertEnabled());
+
+  // Flash telemetry log (LittleFS area reserved in platformio.ini)
+  flashLog.begin();
+
+  // Register scheduler tasks; period 0 = every pass. Hygro and light run
+  // at the configured measurement interval, the thermal task just picks
+  // up frames as the worker completes them.
+  scheduler.add("tx_drain", taskTxDrain, 0);
+  scheduler.add("serial", taskSerialCommands, 0);
+  scheduler.add("mlx_poll", taskMlxPoll, 10);
+  bringup_task = scheduler.add("bringup", taskBringup, 0);
+  hygro_task = scheduler.add("hygro", taskHygro, configManager.getMeasurementInterval());
+  light_task = scheduler.add("light", taskLight, configManager.getMeasurementInterval());
+  scheduler.add("thermal", taskThermal, 100);
+  scheduler.add("txstats", taskTxStats, 10000);
+  scheduler.add("stats", taskProfStats, 10000);
+  scheduler.add("log_flush", taskLogFlush, 60000);
+  scheduler.add("hist_sample", taskHistSample, configManager.getMeasurementInterval());
+#ifdef AMSKY_BENCH_AUTORUN
+  // First run only after bring-up and a few thermal frames have settled
+  bench_task = scheduler.add("bench_auto", taskBenchAutorun, 15000);
+  if (bench_task != nullptr) {
+    bench_task->next_run = millis() + 15000;
   }
-  
-  // Initialize MLX90641 thermal sensor on I2C1
-  if (mlxSensor.begin(&Wire1)) {
-    // MLX sensor is available
+#endif
+
+  // Profiling stages around the loop hot spots
+  prof_hygro = profiler.add("hygro");
+  prof_light = profiler.add("light");
+  prof_sqm = profiler.add("sqm");
+  prof_thermal = profiler.add("thermal");
+  prof_thrmap_fmt = profiler.add("thrmap_fmt");
+  prof_mlx_poll = profiler.add("mlx_poll");
+  prof_tx_drain = profiler.add("tx_drain");
+}
+
+// ---- Scheduler tasks ------------------------------------------------------
+
+// Drain whatever the host can take right now; never blocks. On a
+// multi-drop bus nothing leaves autonomously - queued telemetry waits
+// in the ring (drop-oldest) for an addressed "poll".
+static void taskTxDrain() {
+  ProfScope ps(prof_tx_drain);
+  if (multidrop_active) {
+    return;
+  }
+  txRing.drain();
+}
+
+// Zpracuj případné příkazy z UARTu
+static void taskSerialCommands() {
+  commandProc.poll();
+}
+
+// Single-core fallback: one small non-blocking acquisition step per pass
+// (no-op while the core1 worker is running)
+static void taskMlxPoll() {
+  ProfScope ps(prof_mlx_poll);
+  mlxSensor.poll();
+  // Flash write of a refreshed calibration cache, if the background
+  // verification found a mismatch (writes stay on core0)
+  mlxSensor.serviceCalibrationCache();
+}
+
+// Combine the alert sources and drive the trigger output pin; the LED
+// engine's idle blink is parked while alerts own the pin
+static void updateTriggerOutput() {
+  ledEngine.setBlinkEnabled(false);
+  digitalWrite(TRIGGER_OUT_LED, (alert_cloud_active || alert_light_active) ? HIGH : LOW);
+}
+
+// One bring-up step per pass; each state initializes one sensor and
+// reports its readiness as $ready,<sensor>,<0|1>. Failed sensors are
+// reported too - the hosts distinguish "booting" from "broken".
+static void taskBringup() {
+  switch (bringup_state) {
+  case BRINGUP_SHT4:
+    if (sht4.begin(&Wire1)) {
+      sht4_available = true;
+      sht4.setPrecision(SHT4X_HIGH_PRECISION);
+      sht4.setHeater(SHT4X_NO_HEATER);
+    } else {
+      sht4_available = false;
+    }
+    sentence.begin("ready");
+    sentence.addStr("sht4");
+    sentence.addInt(sht4_available ? 1 : 0);
+    sentence.send();
+    bringup_state = BRINGUP_TSL;
+    break;
+
+  case BRINGUP_TSL:
+    tsl_available = amsSensor.begin(&Wire1);
+    sentence.begin("ready");
+    sentence.addStr("tsl2591");
+    sentence.addInt(tsl_available ? 1 : 0);
+    sentence.send();
+    bringup_state = BRINGUP_MLX;
+    break;
+
+  case BRINGUP_MLX: {
+    // The heavy step: 832 EEPROM words + parameter extraction. It runs
+    // last so the fast sensors are already producing data by now.
+#ifdef MLX_ON_I2C0
+    TwoWire *mlx_wire = &Wire;
+#else
+    TwoWire *mlx_wire = &Wire1;
+#endif
+    if (mlxSensor.begin(mlx_wire)) {
+      // Configured refresh rate (begin() itself programs the default)
+      mlxSensor.setRefreshRate(configManager.getMlxRefresh());
+      // Acquisition and the float-heavy CalculateTo pass run on core1,
+      // loop() on core0 only picks up completed frames
+      mlxSensor.startWorker();
+    }
+    sentence.begin("ready");
+    sentence.addStr("mlx90641");
+    sentence.addInt(mlxSensor.isAvailable() ? 1 : 0);
+    sentence.send();
+    bringup_state = BRINGUP_DONE;
+    if (bringup_task != nullptr) {
+      bringup_task->enabled = false;
+    }
+    break;
+  }
+
+  case BRINGUP_DONE:
+    break;
+  }
+}
+
+static void taskHygro() {
+  if (!sht4_available) {
+    return;
+  }
+
+  ProfScope ps(prof_hygro);
+  sensors_event_t humidity, temp;
+
+  amskyI2cLock();
+  bool sht4_ok = sht4.getEvent(&humidity, &temp);
+  amskyI2cUnlock();
+
+  if (sht4_ok) {
+    // Calculate dew point using Magnus formula
+    // Td = (b * alpha) / (a - alpha)
+    // where alpha = (a * T) / (b + T) + ln(RH/100)
+    // a = 17.27, b = 237.7 for temperatures above 0°C
+    float T = temp.temperature;
+    float RH = humidity.relative_humidity;
+    const float a = 17.27;
+    const float b = 237.7;
+    float alpha = ((a * T) / (b + T)) + fm_logf(RH / 100.0f);
+    float dew_point = (b * alpha) / (a - alpha);
+
+    // Output in CSV format: hygro,<temp>,<humid>,<dew_point>
+    sentence.begin("hygro");
+    sentence.addFloat(temp.temperature, 2);
+    sentence.addFloat(humidity.relative_humidity, 2);
+    sentence.addFloat(dew_point, 2);
+    sentence.send();
+    flashLog.log(sentence.data(), sentence.length(), millis());
+
+    ramHistory.latest.temp_c = T;
+    ramHistory.latest.rh = RH;
+    ramHistory.latest.dew_c = dew_point;
+    ramHistory.latest.valid |= RamHistory::VALID_HYGRO;
   } else {
-    // MLX sensor is not available
+    sentence.begin("hygro");
+    sentence.addInt(-999);
+    sentence.addInt(-999);
+    sentence.addInt(-999);
+    sentence.send();
   }
-  
-  // Initialize configuration manager
-  configManager.begin();
-  configManager.printConfig();
 }
 
-void loop() {
-  // Zpracuj případné příkazy z UARTu (thrmap_on/thrmap_off)
-  handleSerialCommands();
+static void taskLight() {
+  if (!tsl_available || !amsSensor.isAvailable()) {
+    return;
+  }
 
-  // Handle CPU status LED PWM breathing effect
-  unsigned long current_time = millis();
-  float phase = (current_time % CPU_BREATHING_PERIOD) / (float)CPU_BREATHING_PERIOD;
-  float sine_wave = sin(phase * 2 * MY_PI);
-  
-  // Convert sine wave (-1 to 1) to PWM duty cycle (0 to 64) - reduced brightness
-  // Use absolute value to make it always positive, then scale to 25% of original brightness
-  int pwm_value = (int)(32 + 32 * sine_wave);
-  
-  analogWrite(CPU_STATUS_LED, pwm_value);
-  
-  // Handle trigger out LED blinking (1000ms)
-  if (current_time - last_trigger_blink >= TRIGGER_BLINK_INTERVAL) {
-    trigger_led_state = !trigger_led_state;
-    digitalWrite(TRIGGER_OUT_LED, trigger_led_state);
-    last_trigger_blink = current_time;
+  ProfScope ps(prof_light);
+  uint32_t ulux;
+  uint16_t full_raw, ir_raw;
+  const char* gain_str;
+  const char* integration_time_str;
+
+  amskyI2cLock();
+  bool light_ok = amsSensor.readLightData(ulux, full_raw, ir_raw, gain_str, integration_time_str);
+  amskyI2cUnlock();
+
+  if (!light_ok) {
+    // Settings were adjusted, skip this measurement
+    return;
   }
-  
-// Read sensor data every 2 seconds
-  if ((sht4_available || tsl_available || mlxSensor.isAvailable()) && (current_time - last_measurement >= MEASUREMENT_INTERVAL)) {
-    if (sht4_available) {
-      sensors_event_t humidity, temp;
-      
-      if (sht4.getEvent(&humidity, &temp)) {
-        // Calculate dew point using Magnus formula
-        // Td = (b * alpha) / (a - alpha)
-        // where alpha = (a * T) / (b + T) + ln(RH/100)
-        // a = 17.27, b = 237.7 for temperatures above 0°C
-        float T = temp.temperature;
-        float RH = humidity.relative_humidity;
-        const float a = 17.27;
-        const float b = 237.7;
-        float alpha = ((a * T) / (b + T)) + log(RH / 100.0);
-        float dew_point = (b * alpha) / (a - alpha);
-        
-        // Output in CSV format: hygro,<temp>,<humid>,<dew_point>
-        Serial.print("$hygro,");
-        Serial.print(temp.temperature, 2);
-        Serial.print(",");
-        Serial.print(humidity.relative_humidity, 2);
-        Serial.print(",");
-        Serial.print(dew_point, 2);
-        Serial.println();
-      } else {
-        Serial.println("$hygro,-999,-999,-999");
-      }
+
+  // Calculate SQM using new TSL2591 algorithm from raw sensor data
+  float gain_value = amsSensor.getGainValueCurrent();
+  float integration_ms = amsSensor.getIntegrationTimeMsCurrent();
+
+  double sqm_value;
+  {
+    ProfScope ps_sqm(prof_sqm);
+    SQMResult sqm_result = calculate_sqm_from_raw(
+        ir_raw,
+        full_raw,
+        gain_value,
+        integration_ms,
+        1,
+        configManager.getSqmOffsetBase(),
+        configManager.getSqmMagnitudeConst(),
+        0.0
+    );
+
+    if (sqm_result.valid) {
+        sqm_value = (double)sqm_result.mpsas;
+    } else {
+        double lux_double = (double)ulux / 1000000.0;
+        sqm_value = convert_lux_to_sqm(lux_double);
     }
-    
-    if (tsl_available && amsSensor.isAvailable()) {
-      uint32_t ulux;
-      uint16_t full_raw, ir_raw;
-      const char* gain_str;
-      const char* integration_time_str;
-      
-      if (amsSensor.readLightData(ulux, full_raw, ir_raw, gain_str, integration_time_str)) {
-        // Calculate SQM using new TSL2591 algorithm from raw sensor data
-        float gain_value = amsSensor.getGainValueCurrent();
-        float integration_ms = amsSensor.getIntegrationTimeMsCurrent();
-        
-        SQMResult sqm_result = calculate_sqm_from_raw(
-            ir_raw,
-            full_raw,
-            gain_value,
-            integration_ms,
-            1,
-            configManager.getSqmOffsetBase(),
-            configManager.getSqmMagnitudeConst(),
-            0.0
-        );
-        
-        double sqm_value;
-        if (sqm_result.valid) {
-            sqm_value = (double)sqm_result.mpsas;
+  }
+
+  // Filtr u zdroje: medián klouzavého okna + příznak odlehlé hodnoty
+  // (satelit/meteor/letadlo), host už nemusí filtrovat sám
+  SqmFilter::Result sqm_filt = sqmFilter.update((float)sqm_value);
+
+  sentence.begin("light");
+  sentence.addUint(ulux);           // Lux value in microlux
+  sentence.addUint(full_raw);       // Raw full spectrum value
+  sentence.addUint(ir_raw);         // Raw IR value
+  sentence.addStr(gain_str);        // Current gain setting
+  sentence.addStr(integration_time_str); // Current integration time setting
+  sentence.addFloat(sqm_value, 2);  // SQM value in mag/arcsec2 (raw)
+  sentence.addFloat(sqm_filt.median, 2);  // Filtered SQM (window median)
+  sentence.addUint(sqm_filt.outlier ? 1 : 0); // Outlier flag (MAD-based)
+  sentence.send();
+  flashLog.log(sentence.data(), sentence.length(), millis());
+
+  ramHistory.latest.sqm = (float)sqm_value;
+  ramHistory.latest.valid |= RamHistory::VALID_LIGHT;
+
+  // Light alert (dawn / stray light) feeding the trigger output
+  if (configManager.isAlertEnabled() && configManager.isAlertOnLight()) {
+    float lux = (float)ulux / 1000000.0f;
+    alert_light_active = configManager.isAlertLightAbove()
+        ? (lux > configManager.getAlertLightThreshold())
+        : (lux < configManager.getAlertLightThreshold());
+    updateTriggerOutput();
+  }
+}
+
+static void taskThermal() {
+  if (!mlxSensor.isAvailable()) {
+    return;
+  }
+
+  float vdd, ta, center;
+  float corners[4];
+
+  ProfScope ps(prof_thermal);
+
+  // Frames are produced by the core1 worker; this only copies the
+  // latest completed frame and never blocks on I2C
+  if (!mlxSensor.getThermalData(vdd, ta, corners, center)) {
+    return;
+  }
+
+  // Output parameters
+  sentence.begin("cloud_meta");
+  sentence.addFloat(vdd, 3);
+  sentence.addFloat(ta, 3);
+  sentence.send();
+
+  // Output corner and center data, extended with whole-map statistics
+  // and the 8-bucket histogram from the single-pass reduction (existing
+  // parsers ignore the extra fields)
+  const ThermalStats &tstats = mlxSensor.getThermalStats();
+  sentence.begin("cloud");
+  sentence.addFloat(corners[0], 2); // TL
+  sentence.addFloat(corners[1], 2); // TR
+  sentence.addFloat(corners[2], 2); // BL
+  sentence.addFloat(corners[3], 2); // BR
+  sentence.addFloat(center, 2);     // CTR
+  sentence.addFloat(tstats.map.min, 2);
+  sentence.addFloat(tstats.map.max, 2);
+  sentence.addFloat(tstats.map.stddev, 2);
+  for (int i = 0; i < ThermalStats::HIST_BUCKETS; ++i) {
+    sentence.addUint(tstats.histogram[i]);
+  }
+  sentence.send();
+  flashLog.log(sentence.data(), sentence.length(), millis());
+
+  ramHistory.latest.cloud_c = center;
+  ramHistory.latest.ta_c = ta;
+  ramHistory.latest.valid |= RamHistory::VALID_CLOUD;
+
+  // Cloud alert: compare the sky (center region) temperature against the
+  // configured threshold and update the trigger output. The latency
+  // sample runs from frame completion on core1 to the pin write here -
+  // the number the roof controller actually experiences.
+  if (configManager.isAlertEnabled() && configManager.isAlertOnCloud()) {
+    alert_cloud_active = configManager.isAlertCloudBelow()
+        ? (center < configManager.getAlertCloudTempThreshold())
+        : (center > configManager.getAlertCloudTempThreshold());
+    updateTriggerOutput();
+    triggerLatencyHist.record(micros() - mlxSensor.lastFrameMicros());
+  }
+
+  // Volitelné: celá teplotní mapa (16x12 = 192 hodnot) v °C
+  if (thrmap_streaming) {
+    const float *map = mlxSensor.getTemperatureMap();
+    if (map != nullptr) {
+      ProfScope ps_fmt(prof_thrmap_fmt);
+      if (proto_binary) {
+        if (thrmap_delta) {
+          // Keyframe + změněné pixely; na klidné obloze ~90 % úspora
+          thrmapDelta.send(map, MLX90641_PIXEL_COUNT);
         } else {
-            double lux_double = (double)ulux / 1000000.0;
-            sqm_value = convert_lux_to_sqm(lux_double);
+          // Binární frame: 384 B dat + CRC místo ~1.3 KB ASCII
+          telemetrySendThrmap(map, MLX90641_PIXEL_COUNT);
         }
-
-        Serial.print("$light,");
-        Serial.print(ulux);  // Lux value in microlux value with 2 decimal places
-        Serial.print(",");
-        Serial.print(full_raw);    // Raw full spectrum value
-        Serial.print(",");
-        Serial.print(ir_raw);      // Raw IR value
-        Serial.print(",");
-        Serial.print(gain_str); // Current gain setting
-        Serial.print(",");
-        Serial.print(integration_time_str); // Current integration time setting
-        Serial.print(",");
-        Serial.print(sqm_value, 2); // SQM value in mag/arcsec2 with 2 decimal places
-        Serial.println();
       } else {
-        // Settings were adjusted, skip this measurement
-        last_measurement = current_time;
-        return;
-      }
-    }
-    if (mlxSensor.isAvailable()) {
-      float vdd, ta, center;
-      float corners[4];
-      
-      if (mlxSensor.readThermalData(vdd, ta, corners, center)) {
-        // Output parameters
-        Serial.print("$cloud_meta,");
-        Serial.print(vdd, 3);
-        Serial.print(",");
-        Serial.print(ta, 3);
-        Serial.println();
-        
-        // Output corner and center data
-        Serial.print("$cloud,");
-        Serial.print(corners[0], 2); Serial.print(","); // TL
-        Serial.print(corners[1], 2); Serial.print(","); // TR
-        Serial.print(corners[2], 2); Serial.print(","); // BL
-        Serial.print(corners[3], 2); Serial.print(","); // BR
-        Serial.print(center, 2);                         // CTR
-        Serial.println();
-
-        // Volitelné: celá teplotní mapa (16x12 = 192 hodnot) v °C
-        if (thrmap_streaming) {
-          const float *map = mlxSensor.getTemperatureMap();
-          if (map != nullptr) {
-            Serial.print("$thrmap");
-            for (int i = 0; i < MLX90641_PIXEL_COUNT; ++i) {
-              Serial.print(i == 0 ? "," : ",");
-              Serial.print(map[i], 2);
-            }
-            Serial.println();
-          }
+        sentence.begin("thrmap");
+        for (int i = 0; i < MLX90641_PIXEL_COUNT; ++i) {
+          sentence.addFloat(map[i], 2);
         }
+        sentence.send();
       }
     }
+  }
+}
 
-    last_measurement = current_time;
+// Write any partially filled log block out so a quiet station loses at
+// most a minute of history on power cut
+static void taskLogFlush() {
+  flashLog.flush();
+}
+
+// Sample the staging row into the RAM history ring once per
+// measurement interval, keeping the three streams on one time axis
+static void taskHistSample() {
+  ramHistory.sample(millis());
+}
+
+// Periodic TX ring statistics: dropped bytes, pending, high-water mark
+static void taskTxStats() {
+  sentence.begin("txstats");
+  sentence.addUint(txRing.droppedBytes());
+  sentence.addUint(txRing.pending());
+  sentence.addUint(txRing.highWater());
+  sentence.send();
+
+  // Thermal capture accounting: what was produced vs what was lost
+  if (mlxSensor.isAvailable()) {
+    sentence.begin("mlxstats");
+    sentence.addUint(mlxSensor.producedCount());
+    sentence.addUint(mlxSensor.droppedCount());
+    sentence.addUint(mlxSensor.subpageMissCount());
+    sentence.addUint(mlxSensor.acqErrorCount());
+    sentence.addUint(mlxSensor.refreshRateCode());
+    sentence.send();
+  }
+}
+
+// Periodic profiling output: one $stats sentence per stage, counters
+// reset afterwards so each report covers the last interval
+static void taskProfStats() {
+  for (uint8_t i = 0; i < profiler.size(); i++) {
+    const ProfStage &st = profiler.get(i);
+    sentence.begin("stats");
+    sentence.addStr(st.name);
+    sentence.addUint(st.count);
+    sentence.addUint(st.count ? st.min_cycles : 0);
+    sentence.addUint(st.avg());
+    sentence.addUint(st.max_cycles);
+    sentence.send();
+  }
+  profiler.resetAll();
+}
+
+void loop() {
+  // Pass duration (intentional idle excluded) = the jitter any task,
+  // including the alert path, can pick up from the rest of the loop
+  uint32_t pass_start = micros();
+  scheduler.run();
+  loopJitterHist.record(micros() - pass_start);
+
+  // Sleep until the nearest deadline, capped so the per-pass tasks
+  // (serial parsing, TX drain, MLX poll) stay responsive
+  uint32_t idle = scheduler.msUntilNext();
+  if (idle > 10) {
+    idle = 10;
+  }
+  if (idle > 0) {
+    delay(idle);
   }
+}
+
+// Core1 hosts the MLX90641 acquisition worker. It must be launched
+// through the framework's setup1/loop1, not multicore_launch_core1:
+// only then can the core's flash-safe wrappers park core1 while core0
+// erases/programs flash (EEPROM commits, LittleFS journal and log
+// writes). A raw-launched core1 would keep fetching code from XIP
+// flash in the middle of an erase.
+void setup1() {
+}
 
-  delay(10); // Small delay to prevent busy waiting
+void loop1() {
+  // Sleeps in short steps until startWorker() raises the request, then
+  // enters the acquisition loop and never returns
+  mlxSensor.workerRun();
 }
 
@@ -0,0 +1,114 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+
+/**
+ * Cycle-accurate per-stage profiling.
+ *
+ * Wrap a loop stage in a ProfScope and it accumulates min/avg/max cycle
+ * counts from the RP2040 cycle counter (rp2040.getCycleCount(), SysTick
+ * based in the earlephilhower core). Results go out as one $stats
+ * sentence per stage every STATS period and can be dumped on demand with
+ * the stats_show command; counters reset after each emission so the
+ * numbers always describe the last interval.
+ *
+ * Stages are core0-only - the core1 MLX worker has its own timeline and
+ * the accumulators are not cross-core safe.
+ */
+
+struct ProfStage {
+    const char *name;
+    uint32_t count;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+
+    void reset() {
+        count = 0;
+        min_cycles = 0xFFFFFFFF;
+        max_cycles = 0;
+        total_cycles = 0;
+    }
+
+    void record(uint32_t cycles) {
+        count++;
+        total_cycles += cycles;
+        if (cycles < min_cycles) min_cycles = cycles;
+        if (cycles > max_cycles) max_cycles = cycles;
+    }
+
+    uint32_t avg() const {
+        return count ? (uint32_t)(total_cycles / count) : 0;
+    }
+};
+
+class Profiler {
+private:
+    static const uint8_t MAX_STAGES = 10;
+    ProfStage stages[MAX_STAGES];
+    uint8_t stage_count;
+
+public:
+    Profiler() : stage_count(0) {}
+
+    ProfStage *add(const char *name) {
+        if (stage_count >= MAX_STAGES) {
+            return nullptr;
+        }
+        ProfStage &s = stages[stage_count++];
+        s.name = name;
+        s.reset();
+        return &s;
+    }
+
+    uint8_t size() const { return stage_count; }
+    const ProfStage &get(uint8_t i) const { return stages[i]; }
+
+    void resetAll() {
+        for (uint8_t i = 0; i < stage_count; i++) {
+            stages[i].reset();
+        }
+    }
+
+    // Human-readable dump for the stats_show command
+    void print() const {
+        Serial.println("# === Profiling (cycles since last reset) ===");
+        for (uint8_t i = 0; i < stage_count; i++) {
+            const ProfStage &s = stages[i];
+            Serial.print("# ");
+            Serial.print(s.name);
+            Serial.print(": n=");
+            Serial.print(s.count);
+            Serial.print(" min=");
+            Serial.print(s.count ? s.min_cycles : 0);
+            Serial.print(" avg=");
+            Serial.print(s.avg());
+            Serial.print(" max=");
+            Serial.println(s.max_cycles);
+        }
+        Serial.println("# ===========================================");
+    }
+};
+
+extern Profiler profiler;
+
+// RAII timer: measures the enclosing scope into the given stage
+class ProfScope {
+private:
+    ProfStage *stage;
+    uint32_t start;
+
+public:
+    explicit ProfScope(ProfStage *s) : stage(s) {
+        start = rp2040.getCycleCount();
+    }
+
+    ~ProfScope() {
+        if (stage != nullptr) {
+            stage->record(rp2040.getCycleCount() - start);
+        }
+    }
+};
+
+#endif // PROFILER_H
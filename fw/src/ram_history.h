@@ -0,0 +1,196 @@
+#ifndef RAM_HISTORY_H
+#define RAM_HISTORY_H
+
+#include <Arduino.h>
+#include <stdlib.h>
+
+#include "telemetry.h"
+
+/**
+ * RAM-resident telemetry history with on-device aggregates.
+ *
+ * Keeps the last ~30 minutes of hygro/light/cloud values (1800 rows at
+ * the default 1 s measurement interval) in a packed struct-of-arrays
+ * ring: ~29 KB of the RP2040's 264 KB RAM. The measurement tasks only
+ * update a "latest" staging row; a scheduler task samples it into the
+ * ring once per measurement interval, so the three streams stay
+ * aligned on one time axis regardless of their own jitter.
+ *
+ * The point is the query side: the host polls aggregates far more
+ * often than raw data, and answering "median SQM over the window" or
+ * "temperature trend" on-device replaces a steady stream of raw
+ * sentences with one request/response pair.
+ *
+ * Serial API (see processSerialCommand):
+ *   raw <n>    - newest n rows as $rhist sentences
+ *   agg <min>  - aggregates over the last <min> minutes as one $agg
+ *
+ * Fixed-point storage: temperatures/dew/SQM in centi-units (int16),
+ * humidity in centi-percent (uint16).
+ */
+class RamHistory {
+private:
+    static const uint16_t CAP = 1800;
+
+    // Struct-of-arrays: one column per field, indexed by ring position
+    uint32_t t_ms[CAP];
+    int16_t temp_c[CAP];      // air temperature, centi-deg C
+    uint16_t rh[CAP];         // relative humidity, centi-%
+    int16_t dew_c[CAP];       // dew point, centi-deg C
+    int16_t sqm[CAP];         // SQM, centi-mag/arcsec^2
+    int16_t cloud_c[CAP];     // sky (center region) temperature, centi-deg C
+    int16_t ta_c[CAP];        // MLX ambient, centi-deg C
+    uint8_t valid[CAP];       // bitmask of VALID_* per row
+
+    uint16_t head;            // next write position
+    uint16_t count;           // rows stored (saturates at CAP)
+
+    static int16_t clampCenti(float v) {
+        float c = v * 100.0f;
+        if (c > 32767.0f) c = 32767.0f;
+        if (c < -32768.0f) c = -32768.0f;
+        return (int16_t)c;
+    }
+
+    static int cmpU16(const void *a, const void *b) {
+        return (int)*(const int16_t *)a - (int)*(const int16_t *)b;
+    }
+
+public:
+    static const uint8_t VALID_HYGRO = 0x01;
+    static const uint8_t VALID_LIGHT = 0x02;
+    static const uint8_t VALID_CLOUD = 0x04;
+
+    // Staging row; measurement tasks write here as results arrive
+    struct Latest {
+        float temp_c;
+        float rh;
+        float dew_c;
+        float sqm;
+        float cloud_c;
+        float ta_c;
+        uint8_t valid;
+    };
+    Latest latest;
+
+    RamHistory() : head(0), count(0) {
+        memset(&latest, 0, sizeof(latest));
+    }
+
+    // Sample the staging row into the ring; valid bits are consumed so
+    // a stalled sensor shows up as missing data, not as a stale copy
+    void sample(uint32_t now_ms) {
+        t_ms[head] = now_ms;
+        temp_c[head] = clampCenti(latest.temp_c);
+        rh[head] = (uint16_t)(latest.rh * 100.0f);
+        dew_c[head] = clampCenti(latest.dew_c);
+        sqm[head] = clampCenti(latest.sqm);
+        cloud_c[head] = clampCenti(latest.cloud_c);
+        ta_c[head] = clampCenti(latest.ta_c);
+        valid[head] = latest.valid;
+        latest.valid = 0;
+
+        head = (head + 1) % CAP;
+        if (count < CAP) {
+            count++;
+        }
+    }
+
+    uint16_t size() const { return count; }
+
+    // Ring index of the i-th newest row (i = 0 is the most recent)
+    uint16_t indexFromNewest(uint16_t i) const {
+        return (uint16_t)((head + CAP - 1 - i) % CAP);
+    }
+
+    // Emit the newest n rows, oldest first, one $rhist sentence each:
+    // $rhist,<t_ms>,<temp>,<rh>,<dew>,<sqm>,<cloud>,<ta>,<valid>
+    //
+    // Flushed sentence by sentence: a full replay is ~100 KB against
+    // the 4 KB drop-oldest TX ring, which would silently discard all
+    // but the newest rows. An explicit host request means the host is
+    // listening, so blocking on the port is fine (same reasoning as
+    // FlashLog::history).
+    template <typename Builder>
+    void emitRaw(Builder &sentence, uint16_t n) const {
+        if (n > count) {
+            n = count;
+        }
+        for (uint16_t i = n; i > 0; i--) {
+            uint16_t idx = indexFromNewest(i - 1);
+            sentence.begin("rhist");
+            sentence.addUint(t_ms[idx]);
+            sentence.addFloat(temp_c[idx] / 100.0f, 2);
+            sentence.addFloat(rh[idx] / 100.0f, 2);
+            sentence.addFloat(dew_c[idx] / 100.0f, 2);
+            sentence.addFloat(sqm[idx] / 100.0f, 2);
+            sentence.addFloat(cloud_c[idx] / 100.0f, 2);
+            sentence.addFloat(ta_c[idx] / 100.0f, 2);
+            sentence.addUint(valid[idx]);
+            sentence.send();
+            txRing.flush();
+        }
+    }
+
+    // Aggregates over the last window_s seconds, emitted as
+    // $agg,<window_s>,<rows>,<sqm_n>,<sqm_median>,<temp_n>,<temp_slope_c_per_h>
+    template <typename Builder>
+    void emitAggregates(Builder &sentence, uint32_t window_s, uint32_t now_ms) {
+        static int16_t scratch[CAP];  // for the median; query path only
+
+        uint32_t cutoff = now_ms - window_s * 1000;
+        uint16_t rows = 0;
+        uint16_t sqm_n = 0;
+        uint16_t temp_n = 0;
+
+        // Least-squares slope of air temperature vs time; times are
+        // shifted to the window start to keep the float sums small
+        float sum_t = 0, sum_y = 0, sum_tt = 0, sum_ty = 0;
+
+        for (uint16_t i = 0; i < count; i++) {
+            uint16_t idx = indexFromNewest(i);
+            if ((int32_t)(t_ms[idx] - cutoff) < 0) {
+                break;  // rows are time-ordered; older ones follow
+            }
+            rows++;
+            if (valid[idx] & VALID_LIGHT) {
+                scratch[sqm_n++] = sqm[idx];
+            }
+            if (valid[idx] & VALID_HYGRO) {
+                float t = (float)(t_ms[idx] - cutoff) / 1000.0f;
+                float y = temp_c[idx] / 100.0f;
+                sum_t += t;
+                sum_y += y;
+                sum_tt += t * t;
+                sum_ty += t * y;
+                temp_n++;
+            }
+        }
+
+        float sqm_median = 0.0f;
+        if (sqm_n > 0) {
+            qsort(scratch, sqm_n, sizeof(scratch[0]), cmpU16);
+            sqm_median = scratch[sqm_n / 2] / 100.0f;
+        }
+
+        // deg C per hour; needs at least two points and a nonzero spread
+        float slope_c_per_h = 0.0f;
+        float denom = temp_n * sum_tt - sum_t * sum_t;
+        if (temp_n >= 2 && denom != 0.0f) {
+            slope_c_per_h = (temp_n * sum_ty - sum_t * sum_y) / denom * 3600.0f;
+        }
+
+        sentence.begin("agg");
+        sentence.addUint(window_s);
+        sentence.addUint(rows);
+        sentence.addUint(sqm_n);
+        sentence.addFloat(sqm_median, 2);
+        sentence.addUint(temp_n);
+        sentence.addFloat(slope_c_per_h, 3);
+        sentence.send();
+    }
+};
+
+extern RamHistory ramHistory;
+
+#endif // RAM_HISTORY_H
@@ -0,0 +1,93 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+/**
+ * Lightweight cooperative scheduler (no RTOS).
+ *
+ * Replaces the single MEASUREMENT_INTERVAL gate + delay(10) superloop:
+ * every subsystem registers a task with its own period, so the thermal
+ * camera can run at frame rate while hygro stays at a slow cadence.
+ * Tasks run to completion and must not block; period 0 means "every
+ * pass" (serial parsing, TX drain, MLX poll steps).
+ */
+
+typedef void (*SchedTaskFn)();
+
+struct SchedTask {
+    const char *name;
+    SchedTaskFn fn;
+    uint32_t period_ms;       // 0 = run on every pass
+    unsigned long next_run;
+    bool enabled;
+};
+
+class Scheduler {
+private:
+    static const uint8_t MAX_TASKS = 16;
+    SchedTask tasks[MAX_TASKS];
+    uint8_t task_count;
+
+public:
+    Scheduler() : task_count(0) {}
+
+    SchedTask *add(const char *name, SchedTaskFn fn, uint32_t period_ms) {
+        if (task_count >= MAX_TASKS) {
+            return nullptr;
+        }
+        SchedTask &t = tasks[task_count++];
+        t.name = name;
+        t.fn = fn;
+        t.period_ms = period_ms;
+        t.next_run = millis();
+        t.enabled = true;
+        return &t;
+    }
+
+    // Run every task whose deadline has passed (once each per pass)
+    void run() {
+        unsigned long now = millis();
+        for (uint8_t i = 0; i < task_count; i++) {
+            SchedTask &t = tasks[i];
+            if (!t.enabled) {
+                continue;
+            }
+            if (t.period_ms == 0) {
+                t.fn();
+                continue;
+            }
+            if ((long)(now - t.next_run) >= 0) {
+                t.fn();
+                // Keep the cadence period-locked; if we fell far behind
+                // (e.g. host stall), resync instead of firing in a burst
+                t.next_run += t.period_ms;
+                if ((long)(now - t.next_run) >= (long)t.period_ms) {
+                    t.next_run = now + t.period_ms;
+                }
+            }
+        }
+    }
+
+    // Milliseconds until the nearest periodic deadline (for idle delay)
+    uint32_t msUntilNext() const {
+        unsigned long now = millis();
+        long best = -1;
+        for (uint8_t i = 0; i < task_count; i++) {
+            const SchedTask &t = tasks[i];
+            if (!t.enabled || t.period_ms == 0) {
+                continue;
+            }
+            long wait = (long)(t.next_run - now);
+            if (wait < 0) {
+                wait = 0;
+            }
+            if (best < 0 || wait < best) {
+                best = wait;
+            }
+        }
+        return (best < 0) ? 0 : (uint32_t)best;
+    }
+};
+
+#endif // SCHEDULER_H
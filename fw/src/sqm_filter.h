@@ -0,0 +1,137 @@
+#ifndef SQM_FILTER_H
+#define SQM_FILTER_H
+
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+
+/**
+ * Klouzavý mediánový filtr SQM hodnot s MAD detekcí odlehlých měření.
+ *
+ * Satelit, meteor nebo letadlo v zorném poli způsobí krátký skok jasu,
+ * který dosud filtroval až host mediánem posledních N hodnot - streamovali
+ * jsme tedy zašuměná data jen proto, aby je host z větší části zahodil.
+ * Tenhle filtr dělá totéž přímo u zdroje: $light nese vedle raw SQM
+ * i medián okna a příznak odlehlé hodnoty.
+ *
+ * Struktura: kruhový buffer v časovém pořadí + stejná data udržovaná
+ * setříděně ("sorted ring"). Vložení = binární hledání + memmove;
+ * při N = 15 je to pár desítek bajtů jednou za měřicí interval, medián
+ * je pak přímo prostřední prvek bez jakéhokoli řazení.
+ *
+ * Odlehlost: |x - medián| > k * 1.4826 * MAD, kde MAD je medián
+ * absolutních odchylek od mediánu (robustní obdoba směrodatné odchylky,
+ * 1.4826 ji škáluje na sigma normálního rozdělení). Na zcela stabilní
+ * obloze je MAD ~ 0, proto se zdola omezuje šumem senzoru.
+ */
+class SqmFilter {
+private:
+    static const uint8_t WINDOW = 15;        // liché -> medián bez průměrování
+    static constexpr float MAD_SCALE = 1.4826f;
+    static constexpr float MAD_FLOOR = 0.02f; // mag; šumové dno senzoru
+    static constexpr float OUTLIER_K = 3.5f;
+
+    float ring[WINDOW];     // časové pořadí
+    float sorted[WINDOW];   // stejné hodnoty setříděné vzestupně
+    uint8_t count;
+    uint8_t head;           // pozice nejstarší hodnoty v ring[]
+
+    // Odstraní jednu hodnotu ze setříděného pole (binární hledání)
+    void sortedRemove(float value) {
+        uint8_t lo = 0;
+        uint8_t hi = count;
+        while (lo < hi) {
+            uint8_t mid = (uint8_t)((lo + hi) / 2);
+            if (sorted[mid] < value) {
+                lo = (uint8_t)(mid + 1);
+            } else {
+                hi = mid;
+            }
+        }
+        // lo ukazuje na první výskyt hodnoty
+        memmove(sorted + lo, sorted + lo + 1,
+                (size_t)(count - lo - 1) * sizeof(float));
+    }
+
+    // Vloží hodnotu na správnou pozici setříděného pole
+    void sortedInsert(float value, uint8_t len) {
+        uint8_t lo = 0;
+        uint8_t hi = len;
+        while (lo < hi) {
+            uint8_t mid = (uint8_t)((lo + hi) / 2);
+            if (sorted[mid] < value) {
+                lo = (uint8_t)(mid + 1);
+            } else {
+                hi = mid;
+            }
+        }
+        memmove(sorted + lo + 1, sorted + lo,
+                (size_t)(len - lo) * sizeof(float));
+        sorted[lo] = value;
+    }
+
+    static float medianOf(const float *data, uint8_t len) {
+        if (len % 2 == 1) {
+            return data[len / 2];
+        }
+        return 0.5f * (data[len / 2 - 1] + data[len / 2]);
+    }
+
+public:
+    struct Result {
+        float median;    // filtrovaná hodnota (medián okna)
+        float mad;       // škálovaný MAD (odhad sigma)
+        bool outlier;    // aktuální vzorek je odlehlý
+    };
+
+    SqmFilter() : count(0), head(0) {}
+
+    void reset() {
+        count = 0;
+        head = 0;
+    }
+
+    // Vloží nový vzorek a vrátí medián okna + příznak odlehlosti.
+    // Než se okno aspoň z poloviny naplní, je medián málo robustní,
+    // proto se do té doby odlehlost nehlásí.
+    Result update(float x) {
+        if (count == WINDOW) {
+            sortedRemove(ring[head]);
+            ring[head] = x;
+            head = (uint8_t)((head + 1) % WINDOW);
+            sortedInsert(x, (uint8_t)(count - 1));
+        } else {
+            ring[(head + count) % WINDOW] = x;
+            sortedInsert(x, count);
+            count++;
+        }
+
+        Result r;
+        r.median = medianOf(sorted, count);
+
+        // MAD: medián absolutních odchylek; odchylky se třídí vkládáním
+        // do scratch pole (N = 15, jednou za interval - zanedbatelné)
+        float dev[WINDOW];
+        for (uint8_t i = 0; i < count; i++) {
+            float d = fabsf(sorted[i] - r.median);
+            uint8_t j = i;
+            while (j > 0 && dev[j - 1] > d) {
+                dev[j] = dev[j - 1];
+                j--;
+            }
+            dev[j] = d;
+        }
+        r.mad = MAD_SCALE * medianOf(dev, count);
+        if (r.mad < MAD_FLOOR) {
+            r.mad = MAD_FLOOR;
+        }
+
+        r.outlier = (count >= WINDOW / 2) &&
+                    (fabsf(x - r.median) > OUTLIER_K * r.mad);
+        return r;
+    }
+
+    uint8_t samples() const { return count; }
+};
+
+#endif // SQM_FILTER_H
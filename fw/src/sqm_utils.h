@@ -3,6 +3,8 @@
 
 #include <math.h>
 
+#include "fast_math.h"
+
 /**
  * TSL2591 SQM calculation algorithm
  * 
@@ -84,11 +86,11 @@ inline SQMResult calculate_sqm_from_raw(
     // 5) Převod na mag/arcsec^2
     // mpsas = sqmOffsetBase - sqmMagnitude * ln(VIS) + calibrationOffset
     // (ln je přirozený logaritmus)
-    result.mpsas = sqmOffsetBase - sqmMagnitude * logf(VIS) + calibrationOffset;
-    
+    result.mpsas = sqmOffsetBase - sqmMagnitude * fm_logf(VIS) + calibrationOffset;
+
     // 6) Odhad chyby (podle knihovny; bere sqrt z nenormalizovaného vis_raw)
     // dmpsas = sqmMagnitude / sqrt(vis_raw)
-    result.dmpsas = sqmMagnitude / sqrtf(vis_raw);
+    result.dmpsas = sqmMagnitude * fm_rsqrtf(vis_raw);
     
     result.valid = true;
     return result;
@@ -118,7 +120,7 @@ inline SQMResult calculate_sqm_from_normalized_vis(
         return result;
     }
     
-    result.mpsas = sqmOffsetBase - sqmMagnitude * logf(vis_normalized) + calibrationOffset;
+    result.mpsas = sqmOffsetBase - sqmMagnitude * fm_logf(vis_normalized) + calibrationOffset;
     result.valid = true;
     
     return result;
@@ -0,0 +1,383 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+/**
+ * Binary framed telemetry protocol (opt-in via the "proto_bin" command).
+ *
+ * Frame layout on the wire:
+ *   0xAA 0x55 | type (1 B) | length (LE u16, payload bytes) | payload | CRC16 (LE)
+ *
+ * CRC16-CCITT (poly 0x1021, init 0xFFFF) over type + length + payload.
+ * ASCII sentences stay the default; the binary mode exists for the thermal
+ * map, where 192 ASCII floats cost ~1.3 KB and hundreds of Serial.print
+ * calls per frame. The same map as int16 centi-degrees is 384 B and one
+ * write.
+ */
+
+/**
+ * TX ring buffer in front of the serial port.
+ *
+ * Serial.write over USB CDC blocks as soon as the host stops draining its
+ * end (NUC under load, USB hiccup), which used to freeze the whole
+ * measurement loop including the alert LED logic. All telemetry goes into
+ * this fixed ring instead; drain() is called once per loop() iteration and
+ * only writes what Serial.availableForWrite() can take, so emission never
+ * blocks. When the ring overflows, the oldest bytes are dropped and
+ * counted - sampling latency stays independent of host consumption speed.
+ */
+class TxRing {
+private:
+    static const size_t SIZE = 4096;
+    uint8_t buf[SIZE];
+    size_t head;   // write position
+    size_t tail;   // read position
+    size_t used;
+    uint32_t dropped_bytes;
+    size_t high_water;
+
+public:
+    TxRing() : head(0), tail(0), used(0), dropped_bytes(0), high_water(0) {}
+
+    void write(const uint8_t *data, size_t len) {
+        if (len > SIZE) {
+            // Keep only the newest SIZE bytes of an oversized write
+            dropped_bytes += len - SIZE;
+            data += len - SIZE;
+            len = SIZE;
+        }
+
+        // Drop-oldest: make room by advancing the tail
+        if (used + len > SIZE) {
+            size_t drop = used + len - SIZE;
+            tail = (tail + drop) % SIZE;
+            used -= drop;
+            dropped_bytes += drop;
+        }
+
+        size_t first = SIZE - head;
+        if (first > len) {
+            first = len;
+        }
+        memcpy(buf + head, data, first);
+        if (len > first) {
+            memcpy(buf, data + first, len - first);
+        }
+        head = (head + len) % SIZE;
+        used += len;
+        if (used > high_water) {
+            high_water = used;
+        }
+    }
+
+    // Write out as much as the port can take right now without blocking
+    void drain() {
+        size_t room = (size_t)Serial.availableForWrite();
+        while (used > 0 && room > 0) {
+            size_t run = SIZE - tail;
+            if (run > used) run = used;
+            if (run > room) run = room;
+            Serial.write(buf + tail, run);
+            tail = (tail + run) % SIZE;
+            used -= run;
+            room -= run;
+        }
+    }
+
+    // Blocking flush - used before direct Serial prints (command replies)
+    // so their output cannot interleave with half-drained sentences
+    void flush() {
+        while (used > 0) {
+            size_t run = SIZE - tail;
+            if (run > used) run = used;
+            Serial.write(buf + tail, run);
+            tail = (tail + run) % SIZE;
+            used -= run;
+        }
+    }
+
+    size_t pending() const { return used; }
+    uint32_t droppedBytes() const { return dropped_bytes; }
+    size_t highWater() const { return high_water; }
+};
+
+extern TxRing txRing;
+
+// Quiet/listen discipline on a shared RS-485 bus (defined in main.cpp):
+// when set, nothing may reach Serial unsolicited - diagnostic "#" prints
+// included, they would collide with other units' polled bursts
+extern bool multidrop_active;
+
+/**
+ * ASCII sentence builder.
+ *
+ * Builds a whole "$tag,field,field,..." line in a static buffer with
+ * snprintf and sends it with one Serial.write. The previous style of
+ * 5-15 chained Serial.print calls per sentence fragments badly over
+ * USB CDC (each call can flush as its own transfer) and costs host-side
+ * read overhead.
+ *
+ * Wire format: $tag,<seq>,field,...*HH - a per-stream monotonic
+ * sequence number right after the tag and an NMEA-style XOR checksum
+ * (over everything between '$' and '*') at the end. The checksum lets
+ * the host reject torn lines instead of feeding them into statistics;
+ * the sequence number turns silent loss into a detectable gap, so
+ * backfill (history/raw commands) is requested only when needed.
+ *
+ * On a multi-drop bus (see setBusAddress) the tag is prefixed with the
+ * unit's hex address, "$5A:tag,...", so one capture process can sort
+ * the sentences of a whole RS-485 chain by origin.
+ */
+class SentenceBuilder {
+private:
+    // Largest sentence is $thrmap: 192 fields a la "-99.99," -> ~1.4 KB
+    static const size_t BUF_SIZE = 1600;
+    char buf[BUF_SIZE];
+    size_t len;
+
+    // Multi-drop address prefix; 0 = point-to-point, no prefix
+    uint8_t bus_addr;
+
+    // Per-stream sequence counters, keyed by tag
+    struct StreamSeq {
+        char tag[12];
+        uint32_t seq;
+    };
+    static const uint8_t MAX_STREAMS = 16;
+    StreamSeq streams[MAX_STREAMS];
+    uint8_t stream_count;
+
+    uint32_t nextSeq(const char *tag) {
+        for (uint8_t i = 0; i < stream_count; i++) {
+            if (strcmp(streams[i].tag, tag) == 0) {
+                return ++streams[i].seq;
+            }
+        }
+        if (stream_count < MAX_STREAMS) {
+            StreamSeq &st = streams[stream_count++];
+            strncpy(st.tag, tag, sizeof(st.tag) - 1);
+            st.tag[sizeof(st.tag) - 1] = '\0';
+            st.seq = 0;
+            return 0;
+        }
+        return 0;  // table full - seq stays 0 for overflow tags
+    }
+
+    void append(const char *fmt, ...) {
+        if (len >= BUF_SIZE - 1) {
+            return;
+        }
+        va_list args;
+        va_start(args, fmt);
+        int written = vsnprintf(buf + len, BUF_SIZE - len, fmt, args);
+        va_end(args);
+        if (written > 0) {
+            len += (size_t)written;
+            if (len > BUF_SIZE - 1) {
+                len = BUF_SIZE - 1;
+            }
+        }
+    }
+
+public:
+    SentenceBuilder() : len(0), bus_addr(0), stream_count(0) {}
+
+    // Enable the multi-drop address prefix (0 turns it back off)
+    void setBusAddress(uint8_t addr) {
+        bus_addr = addr;
+    }
+
+    void begin(const char *tag) {
+        len = 0;
+        if (bus_addr != 0) {
+            append("$%02X:%s", bus_addr, tag);
+        } else {
+            append("$%s", tag);
+        }
+        append(",%lu", (unsigned long)nextSeq(tag));
+    }
+
+    void addStr(const char *value) {
+        append(",%s", value);
+    }
+
+    void addFloat(float value, uint8_t decimals) {
+        append(",%.*f", decimals, (double)value);
+    }
+
+    void addInt(int32_t value) {
+        append(",%ld", (long)value);
+    }
+
+    void addUint(uint32_t value) {
+        append(",%lu", (unsigned long)value);
+    }
+
+    // Append the checksum, terminate the line and enqueue it into the
+    // TX ring as one block
+    void send() {
+        uint8_t cs = 0;
+        for (size_t i = 1; i < len; i++) {
+            cs ^= (uint8_t)buf[i];
+        }
+        append("*%02X\r\n", cs);
+        txRing.write((const uint8_t *)buf, len);
+    }
+
+    // Access to the last built line (the flash log copies it after send)
+    const char *data() const { return buf; }
+    size_t length() const { return len; }
+};
+
+#define TELEM_SYNC1 0xAA
+#define TELEM_SYNC2 0x55
+
+// Frame types
+#define TELEM_TYPE_THRMAP 0x01
+#define TELEM_TYPE_THRMAP_DELTA 0x02
+
+inline uint16_t telemetryCrc16(const uint8_t *data, size_t len, uint16_t crc = 0xFFFF) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t b = 0; b < 8; b++) {
+            if (crc & 0x8000) {
+                crc = (crc << 1) ^ 0x1021;
+            } else {
+                crc <<= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+// Emit one complete binary frame in a single Serial.write
+inline void telemetrySendFrame(uint8_t type, const uint8_t *payload, uint16_t length) {
+    static uint8_t frame[5 + 512 + 2];
+
+    if (length > 512) {
+        return;
+    }
+
+    frame[0] = TELEM_SYNC1;
+    frame[1] = TELEM_SYNC2;
+    frame[2] = type;
+    frame[3] = length & 0xFF;
+    frame[4] = length >> 8;
+    memcpy(frame + 5, payload, length);
+
+    uint16_t crc = telemetryCrc16(frame + 2, 3 + length);
+    frame[5 + length] = crc & 0xFF;
+    frame[6 + length] = crc >> 8;
+
+    txRing.write(frame, 7 + length);
+}
+
+// Thermal map frame: 192 pixels as int16 centi-degrees (LE), clamped
+inline void telemetrySendThrmap(const float *map, int pixelCount) {
+    static int16_t payload[192];
+
+    if (pixelCount > 192) {
+        pixelCount = 192;
+    }
+    for (int i = 0; i < pixelCount; i++) {
+        float centi = map[i] * 100.0f;
+        if (centi > 32767.0f) centi = 32767.0f;
+        if (centi < -32768.0f) centi = -32768.0f;
+        payload[i] = (int16_t)centi;
+    }
+
+    telemetrySendFrame(TELEM_TYPE_THRMAP, (const uint8_t *)payload,
+                       (uint16_t)(pixelCount * sizeof(int16_t)));
+}
+
+/**
+ * Delta encoder for thrmap streaming.
+ *
+ * A stable clear sky changes only slightly frame to frame, so
+ * retransmitting all 192 pixels wastes the channel - on the radio-serial
+ * stations the full-frame rate saturates the link. This encoder sends a
+ * full keyframe (TELEM_TYPE_THRMAP) every keyframe_interval frames and
+ * otherwise only (index, int16 centi-degree) pairs for pixels that moved
+ * more than threshold_centideg since their last transmitted value.
+ *
+ * Delta payload: u16 count, then count x (u8 index, i16 centi-degrees).
+ * The reference is updated only for transmitted pixels, so quantization
+ * error never accumulates past the threshold.
+ */
+class ThrmapDeltaEncoder {
+private:
+    int16_t reference[192];
+    bool have_keyframe;
+    uint16_t frames_since_key;
+
+public:
+    uint16_t keyframe_interval;   // full frame every N frames
+    uint16_t threshold_centideg;  // minimum change to transmit a pixel
+
+    ThrmapDeltaEncoder()
+        : have_keyframe(false), frames_since_key(0),
+          keyframe_interval(10), threshold_centideg(25) {}
+
+    void reset() {
+        have_keyframe = false;
+        frames_since_key = 0;
+    }
+
+    void send(const float *map, int pixelCount) {
+        if (pixelCount > 192) {
+            pixelCount = 192;
+        }
+
+        int16_t centi[192];
+        for (int i = 0; i < pixelCount; i++) {
+            float c = map[i] * 100.0f;
+            if (c > 32767.0f) c = 32767.0f;
+            if (c < -32768.0f) c = -32768.0f;
+            centi[i] = (int16_t)c;
+        }
+
+        if (!have_keyframe || frames_since_key >= keyframe_interval) {
+            sendKeyframe(centi, pixelCount);
+            return;
+        }
+
+        // Collect changed pixels: u16 count + (u8 idx, i16 value) pairs
+        static uint8_t payload[2 + 192 * 3];
+        uint16_t count = 0;
+        for (int i = 0; i < pixelCount; i++) {
+            int16_t diff = centi[i] - reference[i];
+            if (diff > (int16_t)threshold_centideg || diff < -(int16_t)threshold_centideg) {
+                payload[2 + count * 3] = (uint8_t)i;
+                payload[2 + count * 3 + 1] = (uint8_t)(centi[i] & 0xFF);
+                payload[2 + count * 3 + 2] = (uint8_t)((uint16_t)centi[i] >> 8);
+                reference[i] = centi[i];
+                count++;
+            }
+        }
+
+        // If nearly everything changed, a keyframe is smaller
+        if ((size_t)(2 + count * 3) >= (size_t)pixelCount * sizeof(int16_t)) {
+            sendKeyframe(centi, pixelCount);
+            return;
+        }
+
+        payload[0] = count & 0xFF;
+        payload[1] = count >> 8;
+        telemetrySendFrame(TELEM_TYPE_THRMAP_DELTA, payload,
+                           (uint16_t)(2 + count * 3));
+        frames_since_key++;
+    }
+
+private:
+    void sendKeyframe(const int16_t *centi, int pixelCount) {
+        telemetrySendFrame(TELEM_TYPE_THRMAP, (const uint8_t *)centi,
+                           (uint16_t)(pixelCount * sizeof(int16_t)));
+        memcpy(reference, centi, pixelCount * sizeof(int16_t));
+        have_keyframe = true;
+        frames_since_key = 0;
+    }
+};
+
+#endif // TELEMETRY_H
@@ -25,6 +25,49 @@ except ImportError:
     CLI_AVAILABLE = False
     print("Warning: curses not available.")
 
+def verify_and_strip_sentence(line, seq_state=None):
+    """Validate the framed sentence format from newer firmware.
+
+    Newer firmware emits "$tag,<seq>,fields*HH": an NMEA-style XOR
+    checksum over everything between '$' and '*', and a per-stream
+    monotonic sequence number right after the tag. Returns the line
+    rewritten to the legacy "$tag,fields" layout so index-based parsing
+    stays unchanged, or None when the checksum does not match (torn
+    line). Old-format lines pass through untouched.
+
+    When seq_state (a dict) is given, sequence gaps are detected per
+    tag and reported - that is the host's cue to request backfill via
+    the history/raw commands instead of re-polling.
+    """
+    if not line.startswith('$') or '*' not in line:
+        return line
+    body, _, cs_text = line.rpartition('*')
+    if len(cs_text) != 2:
+        return line
+    try:
+        expected = int(cs_text, 16)
+    except ValueError:
+        return line  # '*' was payload, not a checksum marker
+    cs = 0
+    for ch in body[1:]:
+        cs ^= ord(ch)
+    if cs != expected:
+        return None
+
+    parts = body.split(',')
+    if len(parts) < 2 or not parts[1].isdigit():
+        return body
+    seq = int(parts[1])
+    tag = parts[0]
+    if seq_state is not None:
+        last = seq_state.get(tag)
+        if last is not None and seq != last + 1:
+            missing = seq - last - 1
+            print(f"Sequence gap on {tag}: {missing} sentence(s) lost")
+        seq_state[tag] = seq
+    del parts[1]
+    return ','.join(parts)
+
 
 class SensorData:
     """Container for sensor data with thread-safe access"""
@@ -471,6 +514,7 @@ class SerialReader:
         last_data_time = time.time()
         data_count = 0
         buffer = ""
+        seq_state = {}  # per-tag sequence tracking for gap detection
         reconnect_attempts = 0
         max_reconnect_attempts = 5
         
@@ -509,6 +553,10 @@ class SerialReader:
                             while '\n' in buffer:
                                 line, buffer = buffer.split('\n', 1)
                                 line = line.strip()
+                                line = verify_and_strip_sentence(line, seq_state)
+                                if line is None:
+                                    print("Checksum mismatch, line dropped")
+                                    continue
                                 
                                 if line and ',' in line:
                                     parts = line.split(',')
@@ -917,6 +965,7 @@ class TCPReader:
         last_data_time = time.time()
         data_count = 0
         buffer = ""
+        seq_state = {}  # per-tag sequence tracking for gap detection
         reconnect_attempts = 0
         max_reconnect_attempts = 5
         
@@ -948,6 +997,10 @@ class TCPReader:
                         while '\n' in buffer:
                             line, buffer = buffer.split('\n', 1)
                             line = line.strip()
+                            line = verify_and_strip_sentence(line, seq_state)
+                            if line is None:
+                                print("Checksum mismatch, line dropped")
+                                continue
                             
                             if line and ',' in line:
                                 parts = line.split(',')
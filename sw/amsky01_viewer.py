@@ -41,6 +41,49 @@ ROWS = 12
 COLS = 16
 PIXELS = ROWS * COLS
 
+def verify_and_strip_sentence(line, seq_state=None):
+    """Validate the framed sentence format from newer firmware.
+
+    Newer firmware emits "$tag,<seq>,fields*HH": an NMEA-style XOR
+    checksum over everything between '$' and '*', and a per-stream
+    monotonic sequence number right after the tag. Returns the line
+    rewritten to the legacy "$tag,fields" layout so index-based parsing
+    stays unchanged, or None when the checksum does not match (torn
+    line). Old-format lines pass through untouched.
+
+    When seq_state (a dict) is given, sequence gaps are detected per
+    tag and reported - that is the host's cue to request backfill via
+    the history/raw commands instead of re-polling.
+    """
+    if not line.startswith('$') or '*' not in line:
+        return line
+    body, _, cs_text = line.rpartition('*')
+    if len(cs_text) != 2:
+        return line
+    try:
+        expected = int(cs_text, 16)
+    except ValueError:
+        return line  # '*' was payload, not a checksum marker
+    cs = 0
+    for ch in body[1:]:
+        cs ^= ord(ch)
+    if cs != expected:
+        return None
+
+    parts = body.split(',')
+    if len(parts) < 2 or not parts[1].isdigit():
+        return body
+    seq = int(parts[1])
+    tag = parts[0]
+    if seq_state is not None:
+        last = seq_state.get(tag)
+        if last is not None and seq != last + 1:
+            missing = seq - last - 1
+            print(f"Sequence gap on {tag}: {missing} sentence(s) lost")
+        seq_state[tag] = seq
+    del parts[1]
+    return ','.join(parts)
+
 
 def parse_thrmap(line: str):
     line = line.strip()
@@ -1047,7 +1090,17 @@ class MainWindow(QtWidgets.QMainWindow):
         s = line.strip()
         if not s:
             return
-        
+
+        # Ověření checksumu a odstranění sekvenčního čísla (novější FW);
+        # roztržené řádky se zahodí místo zpracování
+        if not hasattr(self, "seq_state"):
+            self.seq_state = {}
+        s = verify_and_strip_sentence(s, self.seq_state)
+        if s is None:
+            if self.debug:
+                print("! checksum mismatch, line dropped")
+            return
+
         # Aktualizuj timestamp
         self.current_data["timestamp"] = datetime.now().isoformat()
 
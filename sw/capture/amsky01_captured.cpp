@@ -0,0 +1,303 @@
+// AMSKY01 capture daemon: serial port -> mmap'd ring file.
+//
+// The Python tools drop lines when a station streams thrmap at full
+// rate while they plot; this daemon does nothing but capture. It reads
+// the port in large chunks, splits and checksum-validates lines in
+// place (zero copies until the ring append) and stamps them into the
+// ring file from ring_file.h, where the Python side picks them up.
+// Fixed memory, one process per station.
+//
+// Build: make (see Makefile); run:
+//   amsky01_captured --port /dev/ttyACM0 --ring /tmp/amsky01.ring
+
+#include <cctype>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "binlog_file.h"
+#include "ring_file.h"
+
+#define READ_CHUNK 65536
+#define LINE_MAX_LEN 2048
+
+// Ring geometry: 4096 slots x 2 KB fits the largest $thrmap line and
+// holds a few minutes of full-rate traffic in 8 MB
+#define DEFAULT_SLOT_SIZE 2048
+#define DEFAULT_SLOT_COUNT 4096
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static bool open_serial(const char *path, int baud, int *out_fd) {
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        perror("serial open");
+        return false;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        perror("tcgetattr");
+        close(fd);
+        return false;
+    }
+    cfmakeraw(&tio);
+    speed_t speed = (baud == 921600) ? B921600
+                  : (baud == 460800) ? B460800
+                  : (baud == 230400) ? B230400
+                  : B115200;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    // Block until at least one byte, return whatever arrived since -
+    // large reads without polling overhead
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0) {
+        perror("tcsetattr");
+        close(fd);
+        return false;
+    }
+
+    *out_fd = fd;
+    return true;
+}
+
+// NMEA-style XOR checksum check for "$...*HH" lines; lines without the
+// trailer (old firmware, "# " comments) pass through unvalidated
+static bool checksum_ok(const char *line, size_t len) {
+    if (len < 4 || line[0] != '$' || line[len - 3] != '*') {
+        return true;
+    }
+    unsigned expected;
+    if (sscanf(line + len - 2, "%2x", &expected) != 1) {
+        return true;
+    }
+    uint8_t cs = 0;
+    for (size_t i = 1; i < len - 3; i++) {
+        cs ^= (uint8_t)line[i];
+    }
+    return cs == (uint8_t)expected;
+}
+
+// Decode the measurement sentences into packed binlog records. Lines
+// that are not $hygro/$light/$cloud (or the legacy $thermal tag) are
+// simply not logged - the full stream is still in the ring. The line
+// may carry a sequence number as the first field (newer firmware), a
+// multi-drop address prefix on the tag ("$5A:hygro") and a "*HH"
+// checksum trailer; all layouts are handled.
+static void binlog_line(BinLogWriter &log, const char *line, size_t len,
+                        uint64_t t_ns) {
+    if (len < 2 || line[0] != '$') {
+        return;
+    }
+    if (len >= 4 && line[len - 3] == '*') {
+        len -= 3;
+    }
+
+    // Split a bounded copy on commas: fields[0] is the tag
+    char tmp[256];
+    if (len - 1 >= sizeof(tmp)) {
+        return;
+    }
+    memcpy(tmp, line + 1, len - 1);
+    tmp[len - 1] = '\0';
+
+    char *fields[16];
+    int nfields = 0;
+    char *p = tmp;
+    while (nfields < 16) {
+        fields[nfields++] = p;
+        char *comma = strchr(p, ',');
+        if (comma == nullptr) {
+            break;
+        }
+        *comma = '\0';
+        p = comma + 1;
+    }
+
+    // Multi-drop units prefix the tag with their hex bus address; keep
+    // it as the record's origin
+    char *tag = fields[0];
+    uint16_t bus_addr = 0;
+    if (isxdigit((unsigned char)tag[0]) && isxdigit((unsigned char)tag[1]) &&
+        tag[2] == ':') {
+        tag[2] = '\0';
+        bus_addr = (uint16_t)strtoul(tag, nullptr, 16);
+        tag += 3;
+    }
+
+    // Newer firmware inserts the per-stream sequence number right after
+    // the tag; old lines go straight to the data fields. An integer
+    // first field is ambiguous (legacy thermal/light start with ints),
+    // so the seq interpretation is only taken when enough data fields
+    // remain for the record type - otherwise fall back to the old
+    // layout with seq 0.
+    uint32_t seq_val = 0;
+    bool seq_candidate = false;
+    if (nfields > 1 && fields[1][0] != '\0') {
+        char *end = nullptr;
+        unsigned long v = strtoul(fields[1], &end, 10);
+        if (end != fields[1] && *end == '\0') {
+            seq_val = (uint32_t)v;
+            seq_candidate = true;
+        }
+    }
+    uint32_t seq = 0;
+    int data = 1;
+    auto layout = [&](int required) {
+        if (seq_candidate && nfields - 2 >= required) {
+            seq = seq_val;
+            data = 2;
+        } else {
+            seq = 0;
+            data = 1;
+        }
+        return nfields - data >= required;
+    };
+
+    if (strcmp(tag, "hygro") == 0 && layout(3)) {
+        BinPayloadHygro rec;
+        rec.temp_c = (float)atof(fields[data]);
+        rec.rh = (float)atof(fields[data + 1]);
+        rec.dew_c = (float)atof(fields[data + 2]);
+        log.append(BINLOG_REC_HYGRO, seq, t_ns, &rec, sizeof(rec), bus_addr);
+    } else if (strcmp(tag, "light") == 0 && layout(6)) {
+        BinPayloadLight rec;
+        rec.ulux = (uint32_t)strtoul(fields[data], nullptr, 10);
+        rec.raw = (uint32_t)strtoul(fields[data + 1], nullptr, 10);
+        rec.ir = (uint32_t)strtoul(fields[data + 2], nullptr, 10);
+        rec.gain = (uint16_t)atoi(fields[data + 3]);
+        rec.integration_ms = (uint16_t)atoi(fields[data + 4]);
+        rec.sqm = (float)atof(fields[data + 5]);
+        log.append(BINLOG_REC_LIGHT, seq, t_ns, &rec, sizeof(rec), bus_addr);
+    } else if ((strcmp(tag, "cloud") == 0 ||
+                strcmp(tag, "thermal") == 0) && layout(5)) {
+        BinPayloadCloud rec;
+        rec.tl = (float)atof(fields[data]);
+        rec.tr = (float)atof(fields[data + 1]);
+        rec.bl = (float)atof(fields[data + 2]);
+        rec.br = (float)atof(fields[data + 3]);
+        rec.center = (float)atof(fields[data + 4]);
+        log.append(BINLOG_REC_CLOUD, seq, t_ns, &rec, sizeof(rec), bus_addr);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *port = "/dev/ttyACM0";
+    const char *ring_path = "/tmp/amsky01.ring";
+    const char *log_path = nullptr;
+    int baud = 115200;
+    uint32_t slot_size = DEFAULT_SLOT_SIZE;
+    uint32_t slot_count = DEFAULT_SLOT_COUNT;
+
+    for (int i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], "--port") == 0) port = argv[++i];
+        else if (strcmp(argv[i], "--ring") == 0) ring_path = argv[++i];
+        else if (strcmp(argv[i], "--log") == 0) log_path = argv[++i];
+        else if (strcmp(argv[i], "--baud") == 0) baud = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--slots") == 0) slot_count = (uint32_t)atoi(argv[++i]);
+    }
+
+    int fd;
+    if (!open_serial(port, baud, &fd)) {
+        return 1;
+    }
+
+    RingWriter ring;
+    if (!ring.open(ring_path, slot_size, slot_count)) {
+        return 1;
+    }
+
+    // Optional binary log (--log station.amb) for the nightly analysis;
+    // the ring alone serves the live tools
+    BinLogWriter binlog;
+    bool binlog_on = (log_path != nullptr);
+    if (binlog_on && !binlog.open(log_path)) {
+        return 1;
+    }
+
+    fprintf(stderr, "amsky01_captured: %s @ %d -> %s (%u x %u B)%s%s\n",
+            port, baud, ring_path, slot_count, slot_size,
+            binlog_on ? ", log " : "", binlog_on ? log_path : "");
+
+    static char buf[READ_CHUNK + LINE_MAX_LEN];
+    size_t carry = 0;          // bytes of an incomplete line at buf[0..carry)
+    uint64_t lines = 0;
+    uint64_t bad_checksum = 0;
+    uint64_t oversize = 0;
+    time_t last_report = time(nullptr);
+
+    while (true) {
+        ssize_t n = read(fd, buf + carry, READ_CHUNK);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("serial read");
+            break;
+        }
+        if (n == 0) {
+            fprintf(stderr, "amsky01_captured: port closed\n");
+            break;
+        }
+
+        // Split lines in place; 'start' walks the buffer, no copying
+        size_t total = carry + (size_t)n;
+        size_t start = 0;
+        for (size_t i = carry; i < total; i++) {
+            if (buf[i] != '\n') {
+                continue;
+            }
+            size_t len = i - start;
+            while (len > 0 && buf[start + len - 1] == '\r') {
+                len--;
+            }
+            if (len > 0) {
+                if (checksum_ok(buf + start, len)) {
+                    uint64_t t_ns = now_ns();
+                    ring.append(buf + start, len, t_ns);
+                    if (binlog_on) {
+                        binlog_line(binlog, buf + start, len, t_ns);
+                    }
+                    lines++;
+                } else {
+                    bad_checksum++;
+                }
+            }
+            start = i + 1;
+        }
+
+        // Keep the trailing partial line for the next read
+        carry = total - start;
+        if (carry >= LINE_MAX_LEN) {
+            // Runaway line (binary mode garbage) - drop it
+            oversize++;
+            carry = 0;
+        } else if (carry > 0 && start > 0) {
+            memmove(buf, buf + start, carry);
+        }
+
+        time_t now = time(nullptr);
+        if (now - last_report >= 60) {
+            fprintf(stderr,
+                    "amsky01_captured: lines=%" PRIu64 " bad_cksum=%" PRIu64
+                    " oversize=%" PRIu64 " ring_idx=%" PRIu64 "\n",
+                    lines, bad_checksum, oversize, ring.written());
+            last_report = now;
+        }
+    }
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Dump an AMB1 binary log (or a time range of one) as CSV on stdout.
+// Doubles as the smoke test for BinLogReader.
+//
+// Usage: binlog_dump <file.amb> [t0_unix [t1_unix]]
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "binlog_reader.h"
+
+static void print_record(const BinLogRecord &rec) {
+    printf("%" PRIu64 ".%09" PRIu64 ",",
+           (uint64_t)(rec.t_ns / 1000000000ull),
+           (uint64_t)(rec.t_ns % 1000000000ull));
+    switch (rec.type) {
+    case BINLOG_REC_HYGRO: {
+        BinPayloadHygro p;
+        memcpy(&p, rec.payload, sizeof(p));
+        printf("hygro,%u,%u,%.2f,%.2f,%.2f\n", rec.bus_addr, rec.seq, (double)p.temp_c,
+               (double)p.rh, (double)p.dew_c);
+        break;
+    }
+    case BINLOG_REC_LIGHT: {
+        BinPayloadLight p;
+        memcpy(&p, rec.payload, sizeof(p));
+        printf("light,%u,%u,%u,%u,%u,%u,%u,%.2f\n", rec.bus_addr, rec.seq, p.ulux, p.raw,
+               p.ir, p.gain, p.integration_ms, (double)p.sqm);
+        break;
+    }
+    case BINLOG_REC_CLOUD: {
+        BinPayloadCloud p;
+        memcpy(&p, rec.payload, sizeof(p));
+        printf("cloud,%u,%u,%.2f,%.2f,%.2f,%.2f,%.2f\n", rec.bus_addr, rec.seq,
+               (double)p.tl, (double)p.tr, (double)p.bl, (double)p.br,
+               (double)p.center);
+        break;
+    }
+    default:
+        printf("unknown,%u\n", rec.type);
+        break;
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <file.amb> [t0_unix [t1_unix]]\n",
+                argv[0]);
+        return 1;
+    }
+
+    BinLogReader log;
+    if (!log.open(argv[1])) {
+        return 1;
+    }
+
+    uint64_t t0 = 0;
+    uint64_t t1 = UINT64_MAX;
+    if (argc > 2) {
+        t0 = (uint64_t)(atof(argv[2]) * 1e9);
+    }
+    if (argc > 3) {
+        t1 = (uint64_t)(atof(argv[3]) * 1e9);
+    }
+
+    uint64_t n = log.query(t0, t1, [](const BinLogRecord &rec) {
+        print_record(rec);
+        return true;
+    });
+    fprintf(stderr, "%" PRIu64 " of %" PRIu64 " records\n", n, log.count());
+    return 0;
+}
@@ -0,0 +1,191 @@
+#ifndef AMSKY_BINLOG_FILE_H
+#define AMSKY_BINLOG_FILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Packed append-only binary log ("AMB1") for the measurement sentences,
+// written by the capture daemon next to the live ring. One file per
+// station per run; the nightly analysis reads these instead of
+// re-parsing hundreds of MB of ASCII.
+//
+// Layout: BinLogHeader, then fixed-width BinLogRecord entries. Every
+// record carries the capture timestamp and a 24-byte payload packed per
+// record type (see the BinPayload* structs). Fixed width means record i
+// lives at a computable offset, so readers can mmap the file and touch
+// only the pages a time-range query needs.
+//
+// A sidecar index file ("<path>.idx", BinLogIdxEntry per
+// BINLOG_INDEX_INTERVAL records) maps timestamps to record numbers;
+// a time-range query binary-searches the index (typically one page)
+// and then scans at most one interval of records.
+
+#define AMSKY_BINLOG_MAGIC 0x31424D41u  // "AMB1"
+#define AMSKY_BINLOG_VERSION 1u
+
+#define BINLOG_INDEX_INTERVAL 4096u
+
+enum BinLogRecordType : uint16_t {
+    BINLOG_REC_HYGRO = 1,
+    BINLOG_REC_LIGHT = 2,
+    BINLOG_REC_CLOUD = 3,   // "$cloud" ("$thermal" on old firmware)
+};
+
+struct BinLogHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;   // sizeof(BinLogRecord), sanity check for readers
+    uint32_t reserved;
+};
+
+struct BinLogRecord {
+    uint16_t type;          // BinLogRecordType
+    uint16_t bus_addr;      // multi-drop unit address; 0 on point-to-point
+    uint32_t seq;           // per-stream sequence number from the sentence
+    uint64_t t_ns;          // CLOCK_REALTIME capture time
+    uint8_t payload[24];    // one of the BinPayload* structs, zero padded
+};
+
+struct BinPayloadHygro {
+    float temp_c;
+    float rh;
+    float dew_c;
+};
+
+struct BinPayloadLight {
+    uint32_t ulux;          // microlux as sent by the firmware
+    uint32_t raw;
+    uint32_t ir;
+    uint16_t gain;
+    uint16_t integration_ms;
+    float sqm;
+};
+
+struct BinPayloadCloud {
+    float tl;
+    float tr;
+    float bl;
+    float br;
+    float center;
+};
+
+struct BinLogIdxEntry {
+    uint64_t t_ns;          // timestamp of the record at...
+    uint64_t record_index;  // ...this absolute record number
+};
+
+class BinLogWriter {
+private:
+    int fd;
+    int idx_fd;
+    uint64_t records;
+
+    static bool appendAll(int f, const void *data, size_t len) {
+        const uint8_t *p = (const uint8_t *)data;
+        while (len > 0) {
+            ssize_t n = ::write(f, p, len);
+            if (n <= 0) {
+                return false;
+            }
+            p += n;
+            len -= (size_t)n;
+        }
+        return true;
+    }
+
+public:
+    BinLogWriter() : fd(-1), idx_fd(-1), records(0) {}
+
+    ~BinLogWriter() { close(); }
+
+    // Open for appending; a new file gets the header, an existing one is
+    // continued (record count recovered from the file size)
+    bool open(const char *path) {
+        fd = ::open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd < 0) {
+            perror("binlog open");
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            perror("binlog fstat");
+            close();
+            return false;
+        }
+        if (st.st_size == 0) {
+            BinLogHeader hdr;
+            hdr.magic = AMSKY_BINLOG_MAGIC;
+            hdr.version = AMSKY_BINLOG_VERSION;
+            hdr.record_size = sizeof(BinLogRecord);
+            hdr.reserved = 0;
+            if (!appendAll(fd, &hdr, sizeof(hdr))) {
+                perror("binlog header write");
+                close();
+                return false;
+            }
+            records = 0;
+        } else {
+            records = ((size_t)st.st_size - sizeof(BinLogHeader)) /
+                      sizeof(BinLogRecord);
+        }
+
+        char idx_path[512];
+        snprintf(idx_path, sizeof(idx_path), "%s.idx", path);
+        idx_fd = ::open(idx_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (idx_fd < 0) {
+            perror("binlog idx open");
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void append(uint16_t type, uint32_t seq, uint64_t t_ns,
+                const void *payload, size_t payload_len,
+                uint16_t bus_addr = 0) {
+        if (fd < 0 || payload_len > sizeof(BinLogRecord::payload)) {
+            return;
+        }
+
+        BinLogRecord rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.type = type;
+        rec.bus_addr = bus_addr;
+        rec.seq = seq;
+        rec.t_ns = t_ns;
+        memcpy(rec.payload, payload, payload_len);
+        if (!appendAll(fd, &rec, sizeof(rec))) {
+            return;
+        }
+
+        // One index entry per interval, starting with record 0, so a
+        // reader can always seed its scan from the index alone
+        if (records % BINLOG_INDEX_INTERVAL == 0) {
+            BinLogIdxEntry ie;
+            ie.t_ns = t_ns;
+            ie.record_index = records;
+            appendAll(idx_fd, &ie, sizeof(ie));
+        }
+        records++;
+    }
+
+    uint64_t written() const { return records; }
+
+    void close() {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        if (idx_fd >= 0) {
+            ::close(idx_fd);
+            idx_fd = -1;
+        }
+    }
+};
+
+#endif // AMSKY_BINLOG_FILE_H
@@ -0,0 +1,150 @@
+#ifndef AMSKY_BINLOG_READER_H
+#define AMSKY_BINLOG_READER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binlog_file.h"
+
+// Reader side of the AMB1 binary log (see binlog_file.h). The file is
+// mmap'd read-only; a time-range query binary-searches the sidecar
+// index to find the starting record and then walks records until the
+// range ends, so only the pages holding the requested night are ever
+// faulted in - the rest of a season-long file stays on disk.
+class BinLogReader {
+private:
+    uint8_t *map;
+    size_t map_size;
+    BinLogIdxEntry *idx;
+    size_t idx_count;
+    uint64_t record_count;
+
+    static uint8_t *mapFile(const char *path, size_t *out_size) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return nullptr;
+        }
+        void *m = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED,
+                       fd, 0);
+        ::close(fd);
+        if (m == MAP_FAILED) {
+            return nullptr;
+        }
+        *out_size = (size_t)st.st_size;
+        return (uint8_t *)m;
+    }
+
+public:
+    BinLogReader()
+        : map(nullptr), map_size(0), idx(nullptr), idx_count(0),
+          record_count(0) {}
+
+    ~BinLogReader() { close(); }
+
+    bool open(const char *path) {
+        map = mapFile(path, &map_size);
+        if (map == nullptr || map_size < sizeof(BinLogHeader)) {
+            fprintf(stderr, "binlog: cannot map %s\n", path);
+            close();
+            return false;
+        }
+
+        const BinLogHeader *hdr = (const BinLogHeader *)map;
+        if (hdr->magic != AMSKY_BINLOG_MAGIC ||
+            hdr->record_size != sizeof(BinLogRecord)) {
+            fprintf(stderr, "binlog: %s is not an AMB1 file\n", path);
+            close();
+            return false;
+        }
+        record_count =
+            (map_size - sizeof(BinLogHeader)) / sizeof(BinLogRecord);
+
+        // Index is an optimization; a missing sidecar just means the
+        // search seeds at record 0
+        char idx_path[512];
+        snprintf(idx_path, sizeof(idx_path), "%s.idx", path);
+        size_t idx_size = 0;
+        idx = (BinLogIdxEntry *)mapFile(idx_path, &idx_size);
+        idx_count = (idx != nullptr) ? idx_size / sizeof(BinLogIdxEntry) : 0;
+        return true;
+    }
+
+    uint64_t count() const { return record_count; }
+
+    const BinLogRecord *at(uint64_t i) const {
+        if (i >= record_count) {
+            return nullptr;
+        }
+        return (const BinLogRecord *)(map + sizeof(BinLogHeader) +
+                                      (size_t)i * sizeof(BinLogRecord));
+    }
+
+    // First record with t_ns >= t: binary search over the index entries
+    // (one per BINLOG_INDEX_INTERVAL records), then a bounded scan
+    uint64_t lowerBound(uint64_t t) const {
+        uint64_t start = 0;
+        size_t lo = 0;
+        size_t hi = idx_count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (idx[mid].t_ns < t) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo > 0) {
+            start = idx[lo - 1].record_index;
+        }
+
+        for (uint64_t i = start; i < record_count; i++) {
+            if (at(i)->t_ns >= t) {
+                return i;
+            }
+        }
+        return record_count;
+    }
+
+    // Visit every record with t0 <= t_ns < t1; fn(rec) returning false
+    // stops early. Returns the number of records visited.
+    template <typename Fn>
+    uint64_t query(uint64_t t0, uint64_t t1, Fn fn) const {
+        uint64_t visited = 0;
+        for (uint64_t i = lowerBound(t0); i < record_count; i++) {
+            const BinLogRecord *rec = at(i);
+            if (rec->t_ns >= t1) {
+                break;
+            }
+            visited++;
+            if (!fn(*rec)) {
+                break;
+            }
+        }
+        return visited;
+    }
+
+    void close() {
+        if (map != nullptr) {
+            munmap(map, map_size);
+            map = nullptr;
+        }
+        if (idx != nullptr) {
+            munmap(idx, idx_count * sizeof(BinLogIdxEntry));
+            idx = nullptr;
+            idx_count = 0;
+        }
+        record_count = 0;
+    }
+};
+
+#endif // AMSKY_BINLOG_READER_H
@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""Reader for the AMB1 packed binary log (see binlog_file.h).
+
+Loads a whole file (or a time range of it) into a pandas DataFrame with
+the same column names the CSV logs use, so plot_logs.py and the nightly
+analysis work unchanged. The file is parsed with one vectorized
+numpy.frombuffer per record type instead of per-line string parsing -
+a night of data loads in milliseconds.
+
+Usage as a library:
+
+    from binlog_reader import load_dataframe
+    df = load_dataframe("station.amb")                # whole file
+    df = load_dataframe("station.amb", t0_s, t1_s)    # unix-time range
+
+or standalone, dumping the range as CSV:
+
+    python binlog_reader.py station.amb [t0_unix [t1_unix]]
+"""
+
+import struct
+import sys
+
+import numpy as np
+import pandas as pd
+
+MAGIC = 0x31424D41  # "AMB1"
+HEADER = struct.Struct("<IIII")
+
+RECORD_SIZE = 40
+RECORD_DTYPE = np.dtype([
+    ("type", "<u2"),
+    ("bus_addr", "<u2"),
+    ("seq", "<u4"),
+    ("t_ns", "<u8"),
+    ("payload", "V24"),
+])
+
+REC_HYGRO = 1
+REC_LIGHT = 2
+REC_CLOUD = 3
+
+HYGRO_DTYPE = np.dtype([
+    ("temp_c", "<f4"), ("rh", "<f4"), ("dew_c", "<f4"), ("pad", "V12"),
+])
+LIGHT_DTYPE = np.dtype([
+    ("ulux", "<u4"), ("raw", "<u4"), ("ir", "<u4"),
+    ("gain", "<u2"), ("integration_ms", "<u2"), ("sqm", "<f4"), ("pad", "V4"),
+])
+CLOUD_DTYPE = np.dtype([
+    ("tl", "<f4"), ("tr", "<f4"), ("bl", "<f4"), ("br", "<f4"),
+    ("center", "<f4"), ("pad", "V4"),
+])
+
+
+def load_records(path, t0=None, t1=None):
+    """Structured record array for [t0, t1) (unix seconds, None = open)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, _version, record_size, _ = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or record_size != RECORD_SIZE:
+        raise ValueError(f"{path}: not an AMB1 file")
+
+    n = (len(data) - HEADER.size) // RECORD_SIZE
+    recs = np.frombuffer(data, dtype=RECORD_DTYPE, count=n,
+                         offset=HEADER.size)
+    if t0 is not None:
+        recs = recs[recs["t_ns"] >= int(t0 * 1e9)]
+    if t1 is not None:
+        recs = recs[recs["t_ns"] < int(t1 * 1e9)]
+    return recs
+
+
+def _frame(recs, rec_type, payload_dtype, columns):
+    sel = recs[recs["type"] == rec_type]
+    payload = np.frombuffer(sel["payload"].tobytes(), dtype=payload_dtype)
+    df = pd.DataFrame({name: payload[field]
+                       for name, field in columns.items()})
+    df["timestamp"] = pd.to_datetime(sel["t_ns"].astype("int64"), unit="ns",
+                                     utc=True)
+    return df
+
+
+def load_dataframe(path, t0=None, t1=None):
+    """DataFrame in the CSV-log column layout, sorted by timestamp."""
+    recs = load_records(path, t0, t1)
+
+    hygro = _frame(recs, REC_HYGRO, HYGRO_DTYPE,
+                   {"hygro_temp": "temp_c", "hygro_humid": "rh"})
+    # Firmware emits -999 for a failed hygro read
+    hygro.loc[hygro["hygro_temp"] <= -999, ["hygro_temp", "hygro_humid"]] = \
+        np.nan
+
+    light = _frame(recs, REC_LIGHT, LIGHT_DTYPE,
+                   {"light_raw": "raw", "light_ir": "ir",
+                    "light_gain": "gain", "light_integration": "integration_ms",
+                    "light_sqm": "sqm"})
+    # Same formula the CSV logger used for its light_lux_calc column
+    integ = light["light_integration"].replace(0, 100).astype(float)
+    gain = light["light_gain"].replace(0, 1).astype(float)
+    light["light_lux_calc"] = light["light_raw"] * (100.0 / integ) / gain * 0.408
+
+    cloud = _frame(recs, REC_CLOUD, CLOUD_DTYPE,
+                   {"thermal_tl": "tl", "thermal_tr": "tr",
+                    "thermal_bl": "bl", "thermal_br": "br",
+                    "thermal_center": "center"})
+    # The log stores the sentence values (Celsius); the CSV columns are
+    # K*100, which is what plot_logs.py converts back from
+    for col in ("thermal_tl", "thermal_tr", "thermal_bl", "thermal_br",
+                "thermal_center"):
+        cloud[col] = (cloud[col] + 273.15) * 100.0
+
+    df = pd.concat([hygro, light, cloud], ignore_index=True)
+    df = df.sort_values("timestamp").reset_index(drop=True)
+    df["timestamp_utc"] = df["timestamp"]
+    return df
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        print(__doc__)
+        sys.exit(1)
+    t0 = float(sys.argv[2]) if len(sys.argv) > 2 else None
+    t1 = float(sys.argv[3]) if len(sys.argv) > 3 else None
+    frame = load_dataframe(sys.argv[1], t0, t1)
+    frame.to_csv(sys.stdout, index=False)
@@ -0,0 +1,130 @@
+#ifndef AMSKY_RING_FILE_H
+#define AMSKY_RING_FILE_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Mmap'd binary ring file shared between the capture daemon (writer)
+// and the Python tools (readers, see ring_reader.py).
+//
+// Layout: RingHeader followed by slot_count fixed-size slots. The
+// writer stamps each record into the next slot and then publishes it
+// by incrementing write_index with a release store; readers load
+// write_index (acquire) and may map the file read-only from any
+// process. A reader that falls more than slot_count records behind
+// simply loses the overwritten ones - the ring is fixed memory by
+// design, one file per station.
+//
+// Slot payload is one telemetry line (checksum already verified and
+// stripped of CRLF) plus the capture timestamp.
+
+#define AMSKY_RING_MAGIC 0x31524D41u  // "AMR1"
+
+struct RingHeader {
+    uint32_t magic;
+    uint32_t slot_size;     // bytes per slot, header included
+    uint32_t slot_count;
+    uint32_t reserved;
+    volatile uint64_t write_index;  // total records ever written
+};
+
+struct RingSlot {
+    uint64_t t_ns;          // CLOCK_REALTIME capture time
+    uint16_t len;           // payload bytes used
+    // payload follows: slot_size - sizeof(RingSlot) bytes
+};
+
+class RingWriter {
+private:
+    int fd;
+    uint8_t *map;
+    size_t map_size;
+    RingHeader *hdr;
+
+public:
+    RingWriter() : fd(-1), map(nullptr), map_size(0), hdr(nullptr) {}
+
+    ~RingWriter() { close(); }
+
+    size_t payloadCapacity() const {
+        return hdr ? hdr->slot_size - sizeof(RingSlot) : 0;
+    }
+
+    // Create (or reuse, if geometry matches) the ring file
+    bool open(const char *path, uint32_t slot_size, uint32_t slot_count) {
+        map_size = sizeof(RingHeader) + (size_t)slot_size * slot_count;
+
+        fd = ::open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            perror("ring open");
+            return false;
+        }
+
+        struct stat st;
+        bool fresh = (fstat(fd, &st) == 0 && (size_t)st.st_size != map_size);
+        if (fresh && ftruncate(fd, (off_t)map_size) != 0) {
+            perror("ring ftruncate");
+            return false;
+        }
+
+        map = (uint8_t *)mmap(nullptr, map_size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            perror("ring mmap");
+            map = nullptr;
+            return false;
+        }
+
+        hdr = (RingHeader *)map;
+        if (fresh || hdr->magic != AMSKY_RING_MAGIC ||
+            hdr->slot_size != slot_size || hdr->slot_count != slot_count) {
+            memset(map, 0, map_size);
+            hdr->magic = AMSKY_RING_MAGIC;
+            hdr->slot_size = slot_size;
+            hdr->slot_count = slot_count;
+            hdr->write_index = 0;
+        }
+        return true;
+    }
+
+    void append(const char *data, size_t len, uint64_t t_ns) {
+        if (hdr == nullptr) {
+            return;
+        }
+        if (len > payloadCapacity()) {
+            len = payloadCapacity();
+        }
+
+        uint64_t idx = hdr->write_index;
+        uint8_t *slot = map + sizeof(RingHeader) +
+                        (size_t)(idx % hdr->slot_count) * hdr->slot_size;
+        RingSlot *rs = (RingSlot *)slot;
+        rs->t_ns = t_ns;
+        rs->len = (uint16_t)len;
+        memcpy(slot + sizeof(RingSlot), data, len);
+
+        // Publish: readers must see the slot contents before the index
+        __atomic_store_n(&hdr->write_index, idx + 1, __ATOMIC_RELEASE);
+    }
+
+    uint64_t written() const { return hdr ? hdr->write_index : 0; }
+
+    void close() {
+        if (map != nullptr) {
+            munmap(map, map_size);
+            map = nullptr;
+            hdr = nullptr;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+};
+
+#endif // AMSKY_RING_FILE_H
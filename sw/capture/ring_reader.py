@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""Reader for the capture daemon's mmap'd ring file (see ring_file.h).
+
+Layout: RingHeader (magic 'AMR1', slot_size, slot_count, write_index)
+followed by slot_count fixed slots of (t_ns u64, len u16, payload).
+The daemon publishes records by incrementing write_index after filling
+the slot, so polling write_index is enough to tail the stream.
+
+Usage as a library:
+
+    from ring_reader import RingReader
+    for t_ns, line in RingReader("/tmp/amsky01.ring").tail():
+        ...
+
+or standalone, printing lines as they arrive:
+
+    python ring_reader.py /tmp/amsky01.ring
+"""
+
+import mmap
+import struct
+import sys
+import time
+
+MAGIC = 0x31524D41  # "AMR1"
+HEADER = struct.Struct("<IIII Q")
+# t_ns u64, len u16, then 6 padding bytes (C struct alignment)
+SLOT_HDR = struct.Struct("<QH6x")
+
+
+class RingReader:
+    def __init__(self, path):
+        self._f = open(path, "rb")
+        self._map = mmap.mmap(self._f.fileno(), 0, access=mmap.ACCESS_READ)
+        magic, self.slot_size, self.slot_count, _, _ = HEADER.unpack_from(self._map, 0)
+        if magic != MAGIC:
+            raise ValueError(f"{path}: not an AMSKY ring file")
+
+    def write_index(self):
+        return HEADER.unpack_from(self._map, 0)[4]
+
+    def read_slot(self, index):
+        """Record at absolute index; None if already overwritten."""
+        # At diff == slot_count the slot is the one the writer is
+        # currently filling, so only diff < slot_count is safe to read
+        if self.write_index() - index >= self.slot_count:
+            return None
+        off = HEADER.size + (index % self.slot_count) * self.slot_size
+        t_ns, length = SLOT_HDR.unpack_from(self._map, off)
+        data = self._map[off + SLOT_HDR.size:off + SLOT_HDR.size + length]
+        # Re-check after the copy: if the daemon lapped us mid-read the
+        # bytes above may be torn - discard, tail() resynchronizes
+        if self.write_index() - index >= self.slot_count:
+            return None
+        return t_ns, data.decode(errors="replace")
+
+    def tail(self, poll_s=0.05):
+        """Yield (t_ns, line) forever, starting from the current end."""
+        index = self.write_index()
+        while True:
+            end = self.write_index()
+            # If we fell behind the ring, jump to the oldest intact slot
+            # (diff == slot_count is the writer's own slot, skip past it)
+            if end - index >= self.slot_count:
+                index = end - self.slot_count + 1
+            while index < end:
+                rec = self.read_slot(index)
+                index += 1
+                if rec is not None:
+                    yield rec
+            time.sleep(poll_s)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        print(__doc__)
+        sys.exit(1)
+    for t_ns, line in RingReader(sys.argv[1]).tail():
+        print(f"{t_ns / 1e9:.3f} {line}")
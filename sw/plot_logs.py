@@ -26,6 +26,22 @@ import time
 import threading
 import argparse
 
+def load_log_file(path):
+    """Load one log file into a DataFrame with a 'timestamp' column.
+
+    CSV logs from the serial logger are parsed as before; ".amb" files
+    are the capture daemon's packed binary logs, loaded through
+    capture/binlog_reader.py without any per-line ASCII parsing - a
+    night of data loads in milliseconds instead of minutes.
+    """
+    if str(path).endswith('.amb'):
+        sys.path.insert(0, str(Path(__file__).parent / 'capture'))
+        from binlog_reader import load_dataframe
+        return load_dataframe(path)
+    df = pd.read_csv(path, sep=',', header=0)
+    df['timestamp'] = pd.to_datetime(df['timestamp_utc'])
+    return df
+
 def calculate_dew_point(temp_c, humidity_percent):
     """Calculate dew point using Magnus formula"""
     if pd.isna(temp_c) or pd.isna(humidity_percent):
@@ -65,12 +81,11 @@ class LogDataManager:
     def load_file(self, csv_file):
         """Load and process a single CSV file"""
         try:
-            df = pd.read_csv(csv_file, sep=',', header=0)
-            df['timestamp'] = pd.to_datetime(df['timestamp_utc'])
-            
+            df = load_log_file(csv_file)
+
             # Calculate dew point
             df['dew_point'] = df.apply(
-                lambda row: calculate_dew_point(row['hygro_temp'], row['hygro_humid']), 
+                lambda row: calculate_dew_point(row['hygro_temp'], row['hygro_humid']),
                 axis=1
             )
             
@@ -174,17 +189,16 @@ def plot_amsky_data(csv_files):
     dfs = []
     for csv_file in csv_files:
         try:
-            df = pd.read_csv(csv_file, sep=',', header=0)
-            df['timestamp'] = pd.to_datetime(df['timestamp_utc'])
+            df = load_log_file(csv_file)
             df['source_file'] = Path(csv_file).stem
-            
+
             # Calculate dew point
             df['dew_point'] = df.apply(lambda row: calculate_dew_point(row['hygro_temp'], row['hygro_humid']), axis=1)
-            
+
             # Calculate improved light measurements
             df['light_improved'] = df.apply(lambda row: calculate_improved_light(row['light_raw'], row['light_gain'], row['light_integration']), axis=1)
             df['light_ir_improved'] = df.apply(lambda row: calculate_improved_light(row['light_ir'], row['light_gain'], row['light_integration']), axis=1)
-            
+
             dfs.append(df)
             print(f"Loaded {len(df)} data points from {csv_file}")
         except Exception as e:
@@ -383,10 +397,9 @@ def plot_amsky_data_enhanced(csv_files, output_file="amsky01_plots.png", interac
         dfs = []
         for csv_file in csv_files:
             try:
-                df = pd.read_csv(csv_file, sep=',', header=0)
-                df['timestamp'] = pd.to_datetime(df['timestamp_utc'])
+                df = load_log_file(csv_file)
                 df['source_file'] = Path(csv_file).stem
-                
+
                 # Calculate dew point
                 df['dew_point'] = df.apply(lambda row: calculate_dew_point(row['hygro_temp'], row['hygro_humid']), axis=1)
                 
@@ -630,8 +643,8 @@ def main():
         """
     )
     
-    parser.add_argument('csv_files', nargs='+', 
-                       help='CSV files to plot')
+    parser.add_argument('csv_files', nargs='+',
+                       help='CSV or .amb binary log files to plot')
     parser.add_argument('-i', '--interactive', action='store_true',
                        help='Show plot in interactive window')
     parser.add_argument('-r', '--refresh', type=int, metavar='SECS',